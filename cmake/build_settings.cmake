@@ -8,6 +8,7 @@ option(USE_ALLSCALECC "Use allscalecc as compiler" OFF)
 option(ENABLE_PROFILING "Enable AllScale profiling support" OFF)
 option(ALLSCALE_CHECK_BOUNDS "Enable bounds checks for AllScale data items and utility structures" OFF)
 option(ENABLE_DEBUG_OUTPUT "Enable debug output" OFF)
+option(USE_SINGLE_PRECISION_PARTICLES "Store particle properties in single precision" OFF)
 
 # ALLSCALE_CHECK_BOUNDS ... Enable bounds checks for AllScale data items and utility structures
 
@@ -33,6 +34,10 @@ if(ENABLE_DEBUG_OUTPUT)
 	add_definitions(-DENABLE_DEBUG_OUTPUT)
 endif()
 
+if(USE_SINGLE_PRECISION_PARTICLES)
+	add_definitions(-DIPIC3D_SINGLE_PRECISION_PARTICLES)
+endif()
+
 if(NOT DEFINED ALLSCALE_CHECK_BOUNDS AND CMAKE_BUILD_TYPE STREQUAL "Debug")
 	set(ALLSCALE_CHECK_BOUNDS "ON")
 endif()
@@ -0,0 +1,647 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "ipic3d/app/dipole_field.h"
+#include "ipic3d/app/particle_sorting.h"
+#include "ipic3d/app/particle_store.h"
+#include "ipic3d/app/utils/memory_pool.h"
+#include "ipic3d/app/utils/simd.h"
+#include "ipic3d/app/vector.h"
+
+namespace ipic3d {
+
+	/**
+	 * The parameters of a push of particles through the analytic dipole field of the planet.
+	 */
+	struct DipolePushParameters {
+
+		// the dipole field factor: -B0.z * planetRadius^3
+		double magneticFieldTemp;
+
+		// the (uniform) electric field
+		Vector3<double> E;
+
+		// the time step
+		double dt;
+
+		// the speed of light, determining the adaptive sub-cycling
+		double speedOfLight;
+
+	};
+
+	/**
+	 * The parameters of a push of the particles of a single cell through a field given by
+	 * its values at the 8 corners of the cell.
+	 */
+	struct FieldPushParameters {
+
+		// the electric field at the corners of the cell, indexed by [x][y][z]
+		Vector3<double> E[2][2][2];
+
+		// the magnetic field at the corners of the cell, indexed by [x][y][z]
+		Vector3<double> B[2][2][2];
+
+		// the time step
+		double dt;
+
+	};
+
+	namespace detail {
+
+		// the upper limit for the number of sub-cycles of a single particle within a time step
+		constexpr int maxDipoleSubCycles = 100;
+
+		/**
+		 * A table of a per-species property, indexed by species id.
+		 */
+		struct SpeciesPropertyTable {
+
+			double values[SpeciesTable::maxSpecies];
+
+			std::size_t size;
+
+			/**
+			 * Tabulates the given function of the species of the given table.
+			 */
+			template<typename Op>
+			SpeciesPropertyTable(const SpeciesTable& species, const Op& op) : size(species.size()) {
+				for(std::size_t i = 0; i < size; ++i) {
+					values[i] = op(species[SpeciesTable::id_type(i)]);
+				}
+			}
+
+		};
+
+		/**
+		 * Loads the properties of the species of the particles at the given (padded) position of an
+		 * array of species ids. Padding lanes may hold outdated ids, which are mapped to the first species.
+		 */
+		template<typename V>
+		IPIC3D_ALWAYS_INLINE void loadSpeciesProperty(V& res, const std::uint8_t* ids, const SpeciesPropertyTable& table) {
+			constexpr int W = utils::simd::width<V>::value;
+			double lanes[W];
+			for(int l = 0; l < W; ++l) {
+				lanes[l] = table.values[(ids[l] < table.size) ? ids[l] : 0];
+			}
+			utils::simd::load(res, lanes);
+		}
+
+		/**
+		 * Evaluates the analytic dipole field at the given absolute positions and determines the
+		 * number of sub-cycles the Boris method requires to resolve the gyration of particles with
+		 * the given charge over mass ratio, limited to [1,maxDipoleSubCycles].
+		 */
+		template<typename V>
+		IPIC3D_ALWAYS_INLINE void evaluateDipoleField(const V& x, const V& y, const V& z, const V& qom, const DipolePushParameters& params, V& Bx, V& By, V& Bz, V& sub_cycles) {
+			IPIC3D_NO_FP_CONTRACT
+			using namespace utils::simd;
+
+			// calculate 3 Cartesian components of the magnetic field
+			DipoleField(params.magneticFieldTemp).evaluate(x, y, z, Bx, By, Bz);
+
+			// adaptive sub-cycling for computing velocity
+			V B_mag = Bx * Bx + By * By + Bz * Bz;
+			V abs_qom = (qom < 0.0) ? -qom : qom;
+			V dt_sub = M_PI * params.speedOfLight / (4.0 * abs_qom * B_mag);
+			V ratio = params.dt / dt_sub;
+
+			// limit the number of sub-cycles (covering NaN ratios as well)
+			ratio = (ratio < double(maxDipoleSubCycles - 1)) ? ratio : double(maxDipoleSubCycles - 1);
+			ratio = (ratio > 0.0) ? ratio : 0.0;
+			floorNonNegative(sub_cycles, ratio);
+			sub_cycles = sub_cycles + 1.0;
+		}
+
+		/**
+		 * Determines the number of sub-cycles required by each particle of the given store within
+		 * the analytic dipole field, processing width<V> particles at a time.
+		 */
+		template<typename V, typename T>
+		IPIC3D_ALWAYS_INLINE void countDipoleSubCyclesBatch(const BasicParticleStore<T>& particles, const DipolePushParameters& params, std::uint8_t* counts) {
+			IPIC3D_NO_FP_CONTRACT
+			using namespace utils::simd;
+
+			constexpr int W = width<V>::value;
+			const std::size_t size = particles.size();
+
+			using Store = BasicParticleStore<T>;
+			const T* px = particles.data(Store::X);
+			const T* py = particles.data(Store::Y);
+			const T* pz = particles.data(Store::Z);
+			const std::uint8_t* ids = particles.getSpeciesIds();
+
+			// the charge over mass ratio of each species
+			const SpeciesPropertyTable qoms(particles.getSpecies(), [](const Species& s) { return s.qom; });
+
+			const Vector3<double>& origin = particles.getFrameOrigin();
+			const Vector3<double>& width = particles.getFrameWidth();
+
+			for(std::size_t i = 0; i < size; i += W) {
+
+				V x, y, z, qom;
+				load(x, px + i);
+				load(y, py + i);
+				load(z, pz + i);
+				loadSpeciesProperty(qom, ids + i, qoms);
+
+				x = origin.x + x * width.x;
+				y = origin.y + y * width.y;
+				z = origin.z + z * width.z;
+
+				V Bx, By, Bz, sub_cycles;
+				evaluateDipoleField(x, y, z, qom, params, Bx, By, Bz, sub_cycles);
+
+				double lanes[W];
+				store(lanes, sub_cycles);
+				for(int l = 0; l < W && i + l < size; ++l) {
+					counts[i + l] = std::uint8_t(lanes[l]);
+				}
+			}
+		}
+
+		/**
+		 * Provides the charge over mass ratio of particles of mixed species, gathered per particle.
+		 */
+		struct MixedSpeciesQom {
+
+			const std::uint8_t* ids;
+
+			SpeciesPropertyTable qoms;
+
+			MixedSpeciesQom(const std::uint8_t* ids, const SpeciesTable& species)
+				: ids(ids), qoms(species, [](const Species& s) { return s.qom; }) {}
+
+			template<typename V>
+			IPIC3D_ALWAYS_INLINE void load(V& res, std::size_t i) const {
+				loadSpeciesProperty(res, ids + i, qoms);
+			}
+
+		};
+
+		/**
+		 * Provides the charge over mass ratio of a range of particles of a single species.
+		 */
+		struct UniformSpeciesQom {
+
+			double qom;
+
+			template<typename V>
+			IPIC3D_ALWAYS_INLINE void load(V& res, std::size_t) const {
+				utils::simd::broadcast(res, qom);
+			}
+
+		};
+
+		/**
+		 * Advances the width<V> particles starting at index i of the given arrays by one time step
+		 * using the Boris method within the analytic dipole field. Each particle is sub-cycled
+		 * individually; lanes which completed their sub-cycles, as well as lanes at or beyond the
+		 * given end index, are masked.
+		 *
+		 * The sequence of floating point operations mirrors Particle::updateVelocity and
+		 * Particle::updatePosition, such that all instantiations produce bit-wise identical results.
+		 * Properties stored in single precision are widened on load and only rounded once the
+		 * particle completed all of its sub-cycles. Relative positions are converted to absolute
+		 * coordinates on load and back on store.
+		 */
+		template<typename V, typename T, typename Qom>
+		IPIC3D_ALWAYS_INLINE void pushDipoleLanes(BasicParticleStore<T>& particles, std::size_t i, std::size_t end, const Qom& qoms, const DipolePushParameters& params) {
+			IPIC3D_NO_FP_CONTRACT
+			using namespace utils::simd;
+
+			using Store = BasicParticleStore<T>;
+			T* px = particles.data(Store::X) + i;
+			T* py = particles.data(Store::Y) + i;
+			T* pz = particles.data(Store::Z) + i;
+			T* pvx = particles.data(Store::VX) + i;
+			T* pvy = particles.data(Store::VY) + i;
+			T* pvz = particles.data(Store::VZ) + i;
+
+			// the frame positions are stored relative to
+			const Vector3<double>& origin = particles.getFrameOrigin();
+			const Vector3<double>& width = particles.getFrameWidth();
+			const double invWidthX = 1.0 / width.x;
+			const double invWidthY = 1.0 / width.y;
+			const double invWidthZ = 1.0 / width.z;
+
+			const double dt = params.dt;
+
+			V x, y, z, vx, vy, vz, qom;
+			load(x, px);
+			load(y, py);
+			load(z, pz);
+			load(vx, pvx);
+			load(vy, pvy);
+			load(vz, pvz);
+			qoms.load(qom, i);
+
+			// convert to absolute positions
+			x = origin.x + x * width.x;
+			y = origin.y + y * width.y;
+			z = origin.z + z * width.z;
+
+			// evaluate the field and the number of sub-cycles
+			V Bx, By, Bz, sub_cycles;
+			evaluateDipoleField(x, y, z, qom, params, Bx, By, Bz, sub_cycles);
+
+			// mask padding lanes beyond the end of the range
+			V index;
+			iota(index, double(i));
+			sub_cycles = (index < double(end)) ? sub_cycles : 0.0;
+
+			V dt_sub = dt / sub_cycles;
+
+			// constants of the Boris method
+			V k = qom * 0.5 * dt_sub;
+			V tx = k * Bx;
+			V ty = k * By;
+			V tz = k * Bz;
+			V t_mag2 = tx * tx + ty * ty + tz * tz;
+			V den = 1.0 + t_mag2;
+			V sx = (2.0 * tx) / den;
+			V sy = (2.0 * ty) / den;
+			V sz = (2.0 * tz) / den;
+			V kEx = k * params.E.x;
+			V kEy = k * params.E.y;
+			V kEz = k * params.E.z;
+
+			const int max_cycles = int(reduceMax(sub_cycles));
+			for(int cyc_cnt = 0; cyc_cnt < max_cycles; cyc_cnt++) {
+
+				// update velocity
+				V v_minus_x = vx + kEx;
+				V v_minus_y = vy + kEy;
+				V v_minus_z = vz + kEz;
+
+				V v_prime_x = v_minus_x + (v_minus_y * tz - v_minus_z * ty);
+				V v_prime_y = v_minus_y + (v_minus_z * tx - v_minus_x * tz);
+				V v_prime_z = v_minus_z + (v_minus_x * ty - v_minus_y * tx);
+
+				V v_plus_x = v_minus_x + (v_prime_y * sz - v_prime_z * sy);
+				V v_plus_y = v_minus_y + (v_prime_z * sx - v_prime_x * sz);
+				V v_plus_z = v_minus_z + (v_prime_x * sy - v_prime_y * sx);
+
+				V nvx = v_plus_x + kEx;
+				V nvy = v_plus_y + kEy;
+				V nvz = v_plus_z + kEz;
+
+				// update position
+				V nx = x + nvx * dt_sub;
+				V ny = y + nvy * dt_sub;
+				V nz = z + nvz * dt_sub;
+
+				// only commit lanes still sub-cycling
+				auto active = (double(cyc_cnt) < sub_cycles);
+				vx = active ? nvx : vx;
+				vy = active ? nvy : vy;
+				vz = active ? nvz : vz;
+				x = active ? nx : x;
+				y = active ? ny : y;
+				z = active ? nz : z;
+			}
+
+			store(px, (x - origin.x) * invWidthX);
+			store(py, (y - origin.y) * invWidthY);
+			store(pz, (z - origin.z) * invWidthZ);
+			store(pvx, vx);
+			store(pvy, vy);
+			store(pvz, vz);
+		}
+
+		/**
+		 * Advances the particles [begin,end) of the given store by one time step using the Boris
+		 * method within the analytic dipole field, processing width<V> particles at a time. Batches
+		 * only extend beyond the end of the range if it is the end of the property arrays and the
+		 * batches are aligned to their padding, such that neither the particles following the range
+		 * nor the subsequent arrays are touched. Remaining particles are processed one at a time.
+		 */
+		template<typename V, typename T, typename Qom>
+		IPIC3D_ALWAYS_INLINE void pushDipoleRange(BasicParticleStore<T>& particles, std::size_t begin, std::size_t end, const Qom& qoms, const DipolePushParameters& params) {
+			constexpr int W = utils::simd::width<V>::value;
+			const bool padded = end == particles.size() && begin % W == 0;
+			const std::size_t last = padded ? end : begin + (end - begin) / W * W;
+			std::size_t i = begin;
+			for(; i < last; i += W) {
+				pushDipoleLanes<V>(particles, i, end, qoms, params);
+			}
+			for(; i < end; ++i) {
+				pushDipoleLanes<double>(particles, i, end, qoms, params);
+			}
+		}
+
+		/**
+		 * Advances all particles of the given store by one time step using the Boris method within
+		 * the analytic dipole field, processing width<V> particles at a time. If the particles are
+		 * grouped by species, each species is pushed separately with its charge over mass ratio
+		 * broadcast, such that batches never mix the sub-cycling schedules of different species.
+		 * Otherwise, the ratio is gathered per particle.
+		 */
+		template<typename V, typename T>
+		IPIC3D_ALWAYS_INLINE void pushDipoleBatch(BasicParticleStore<T>& particles, const DipolePushParameters& params) {
+			const std::size_t size = particles.size();
+			const std::uint8_t* ids = particles.getSpeciesIds();
+			const SpeciesTable& species = particles.getSpecies();
+
+			if (!std::is_sorted(ids, ids + size)) {
+				pushDipoleRange<V>(particles, 0, size, MixedSpeciesQom(ids, species), params);
+				return;
+			}
+
+			for(std::size_t begin = 0; begin < size;) {
+				const std::size_t end = std::upper_bound(ids + begin, ids + size, ids[begin]) - ids;
+				pushDipoleRange<V>(particles, begin, end, UniformSpeciesQom{ species[ids[begin]].qom }, params);
+				begin = end;
+			}
+		}
+
+		/**
+		 * Advances all particles of the given store by one time step using the Boris method within
+		 * a field interpolated trilinearly from the corners of the cell, processing width<V> particles
+		 * at a time. The frame of the store has to span the cell, such that the relative positions of
+		 * particles are their interpolation weights. The corner values are broadcast once and shared
+		 * by all particles of the cell.
+		 *
+		 * The sequence of floating point operations mirrors trilinearInterpolationF2P (of a unit volume),
+		 * Particle::updateVelocity and Particle::updatePosition, such that all instantiations produce
+		 * bit-wise identical results.
+		 */
+		template<typename V, typename T>
+		IPIC3D_ALWAYS_INLINE void pushInterpolatedBatch(BasicParticleStore<T>& particles, const FieldPushParameters& params) {
+			IPIC3D_NO_FP_CONTRACT
+			using namespace utils::simd;
+
+			constexpr int W = width<V>::value;
+			const std::size_t size = particles.size();
+
+			using Store = BasicParticleStore<T>;
+			T* px = particles.data(Store::X);
+			T* py = particles.data(Store::Y);
+			T* pz = particles.data(Store::Z);
+			T* pvx = particles.data(Store::VX);
+			T* pvy = particles.data(Store::VY);
+			T* pvz = particles.data(Store::VZ);
+			const std::uint8_t* ids = particles.getSpeciesIds();
+
+			const double dt = params.dt;
+
+			// the factor of the Boris method of each species, uniform for all particles of a species
+			const SpeciesPropertyTable ks(particles.getSpecies(), [&](const Species& s) { return s.qom * 0.5 * dt; });
+
+			const Vector3<double>& origin = particles.getFrameOrigin();
+			const Vector3<double>& width = particles.getFrameWidth();
+			const double invWidthX = 1.0 / width.x;
+			const double invWidthY = 1.0 / width.y;
+			const double invWidthZ = 1.0 / width.z;
+
+			// broadcast the corner values once for all particles of the cell
+			V cEx[8], cEy[8], cEz[8], cBx[8], cBy[8], cBz[8];
+			for(int c = 0; c < 8; ++c) {
+				const auto& E = params.E[c >> 2][(c >> 1) & 1][c & 1];
+				const auto& B = params.B[c >> 2][(c >> 1) & 1][c & 1];
+				broadcast(cEx[c], E.x);
+				broadcast(cEy[c], E.y);
+				broadcast(cEz[c], E.z);
+				broadcast(cBx[c], B.x);
+				broadcast(cBy[c], B.y);
+				broadcast(cBz[c], B.z);
+			}
+
+			// property arrays are padded to the maximum SIMD width, so the last batch may be processed as a whole
+			for(std::size_t i = 0; i < size; i += W) {
+
+				V x, y, z, vx, vy, vz, k;
+				load(x, px + i);
+				load(y, py + i);
+				load(z, pz + i);
+				load(vx, pvx + i);
+				load(vy, pvy + i);
+				load(vz, pvz + i);
+				loadSpeciesProperty(k, ids + i, ks);
+
+				// interpolate the fields at the particles' positions
+				const V wx[2] = { 1.0 - x, x };
+				const V wy[2] = { 1.0 - y, y };
+				const V wz[2] = { 1.0 - z, z };
+
+				V Ex, Ey, Ez, Bx, By, Bz;
+				broadcast(Ex, 0.0);
+				Ey = Ez = Bx = By = Bz = Ex;
+				for(int c = 0; c < 8; ++c) {
+					V fac = wx[c >> 2] * wy[(c >> 1) & 1] * wz[c & 1];
+					Ex = Ex + cEx[c] * fac;
+					Ey = Ey + cEy[c] * fac;
+					Ez = Ez + cEz[c] * fac;
+					Bx = Bx + cBx[c] * fac;
+					By = By + cBy[c] * fac;
+					Bz = Bz + cBz[c] * fac;
+				}
+
+				// update velocity
+				V tx = k * Bx;
+				V ty = k * By;
+				V tz = k * Bz;
+				V t_mag2 = tx * tx + ty * ty + tz * tz;
+				V den = 1.0 + t_mag2;
+				V sx = (2.0 * tx) / den;
+				V sy = (2.0 * ty) / den;
+				V sz = (2.0 * tz) / den;
+
+				V v_minus_x = vx + k * Ex;
+				V v_minus_y = vy + k * Ey;
+				V v_minus_z = vz + k * Ez;
+
+				V v_prime_x = v_minus_x + (v_minus_y * tz - v_minus_z * ty);
+				V v_prime_y = v_minus_y + (v_minus_z * tx - v_minus_x * tz);
+				V v_prime_z = v_minus_z + (v_minus_x * ty - v_minus_y * tx);
+
+				V v_plus_x = v_minus_x + (v_prime_y * sz - v_prime_z * sy);
+				V v_plus_y = v_minus_y + (v_prime_z * sx - v_prime_x * sz);
+				V v_plus_z = v_minus_z + (v_prime_x * sy - v_prime_y * sx);
+
+				vx = v_plus_x + k * Ex;
+				vy = v_plus_y + k * Ey;
+				vz = v_plus_z + k * Ez;
+
+				// update position in absolute coordinates
+				V ax = (origin.x + x * width.x) + vx * dt;
+				V ay = (origin.y + y * width.y) + vy * dt;
+				V az = (origin.z + z * width.z) + vz * dt;
+
+				store(px + i, (ax - origin.x) * invWidthX);
+				store(py + i, (ay - origin.y) * invWidthY);
+				store(pz + i, (az - origin.z) * invWidthZ);
+				store(pvx + i, vx);
+				store(pvy + i, vy);
+				store(pvz + i, vz);
+			}
+		}
+
+		template<typename T>
+		IPIC3D_SCALAR_FUNCTION
+		void pushInterpolatedScalar(BasicParticleStore<T>& particles, const FieldPushParameters& params) {
+			pushInterpolatedBatch<double>(particles, params);
+		}
+
+		template<typename T>
+		IPIC3D_SCALAR_FUNCTION
+		void pushDipoleScalar(BasicParticleStore<T>& particles, const DipolePushParameters& params) {
+			pushDipoleBatch<double>(particles, params);
+		}
+
+		template<typename T>
+		IPIC3D_SCALAR_FUNCTION
+		void countDipoleSubCyclesScalar(const BasicParticleStore<T>& particles, const DipolePushParameters& params, std::uint8_t* counts) {
+			countDipoleSubCyclesBatch<double>(particles, params, counts);
+		}
+
+		#ifdef IPIC3D_X86_SIMD
+
+			template<typename T>
+			IPIC3D_SIMD_FUNCTION("avx2")
+			void pushDipoleAVX2(BasicParticleStore<T>& particles, const DipolePushParameters& params) {
+				pushDipoleBatch<utils::simd::double4>(particles, params);
+			}
+
+			template<typename T>
+			IPIC3D_SIMD_FUNCTION("avx512f")
+			void pushDipoleAVX512(BasicParticleStore<T>& particles, const DipolePushParameters& params) {
+				pushDipoleBatch<utils::simd::double8>(particles, params);
+			}
+
+			template<typename T>
+			IPIC3D_SIMD_FUNCTION("avx2")
+			void countDipoleSubCyclesAVX2(const BasicParticleStore<T>& particles, const DipolePushParameters& params, std::uint8_t* counts) {
+				countDipoleSubCyclesBatch<utils::simd::double4>(particles, params, counts);
+			}
+
+			template<typename T>
+			IPIC3D_SIMD_FUNCTION("avx512f")
+			void countDipoleSubCyclesAVX512(const BasicParticleStore<T>& particles, const DipolePushParameters& params, std::uint8_t* counts) {
+				countDipoleSubCyclesBatch<utils::simd::double8>(particles, params, counts);
+			}
+
+			template<typename T>
+			IPIC3D_SIMD_FUNCTION("avx2")
+			void pushInterpolatedAVX2(BasicParticleStore<T>& particles, const FieldPushParameters& params) {
+				pushInterpolatedBatch<utils::simd::double4>(particles, params);
+			}
+
+			template<typename T>
+			IPIC3D_SIMD_FUNCTION("avx512f")
+			void pushInterpolatedAVX512(BasicParticleStore<T>& particles, const FieldPushParameters& params) {
+				pushInterpolatedBatch<utils::simd::double8>(particles, params);
+			}
+
+		#endif
+
+	}
+
+	/**
+	 * Advances all particles of the given store by a single time step using the Boris method
+	 * within the analytic dipole field, utilizing the given instruction set extensions. All
+	 * extensions produce bit-wise identical results. Computations are conducted in double
+	 * precision, independently of the precision the particles are stored in. Stores grouped
+	 * by species (see groupParticlesBySubCycles) are pushed one species at a time.
+	 *
+	 * @param particles the particles to be moved
+	 * @param params the field and time step parameters
+	 * @param level the instruction set extensions to be used, must be supported by the CPU
+	 */
+	template<typename T>
+	void pushParticlesInDipoleField(BasicParticleStore<T>& particles, const DipolePushParameters& params, utils::simd::Level level = utils::simd::getSupportedLevel()) {
+		if (particles.empty()) return;
+		switch(level) {
+			#ifdef IPIC3D_X86_SIMD
+				case utils::simd::Level::AVX512: detail::pushDipoleAVX512(particles, params); return;
+				case utils::simd::Level::AVX2:   detail::pushDipoleAVX2(particles, params); return;
+			#endif
+			default: detail::pushDipoleScalar(particles, params); return;
+		}
+	}
+
+	/**
+	 * Advances all particles of the given store by a single time step using the Boris method
+	 * within a field interpolated from the corners of their cell, utilizing the given instruction
+	 * set extensions. The frame of the store has to span the cell. All extensions produce bit-wise
+	 * identical results.
+	 *
+	 * @param particles the particles of a single cell to be moved
+	 * @param params the corner values of the field and the time step
+	 * @param level the instruction set extensions to be used, must be supported by the CPU
+	 */
+	template<typename T>
+	void pushParticlesInInterpolatedField(BasicParticleStore<T>& particles, const FieldPushParameters& params, utils::simd::Level level = utils::simd::getSupportedLevel()) {
+		if (particles.empty()) return;
+		switch(level) {
+			#ifdef IPIC3D_X86_SIMD
+				case utils::simd::Level::AVX512: detail::pushInterpolatedAVX512(particles, params); return;
+				case utils::simd::Level::AVX2:   detail::pushInterpolatedAVX2(particles, params); return;
+			#endif
+			default: detail::pushInterpolatedScalar(particles, params); return;
+		}
+	}
+
+	/**
+	 * Determines the number of sub-cycles each particle of the given store requires within the
+	 * analytic dipole field, as applied by pushParticlesInDipoleField.
+	 *
+	 * @param particles the particles to be inspected
+	 * @param params the field and time step parameters
+	 * @param counts the array to write the number of sub-cycles to, one entry per particle
+	 * @param level the instruction set extensions to be used, must be supported by the CPU
+	 */
+	template<typename T>
+	void countSubCyclesInDipoleField(const BasicParticleStore<T>& particles, const DipolePushParameters& params, std::uint8_t* counts, utils::simd::Level level = utils::simd::getSupportedLevel()) {
+		if (particles.empty()) return;
+		switch(level) {
+			#ifdef IPIC3D_X86_SIMD
+				case utils::simd::Level::AVX512: detail::countDipoleSubCyclesAVX512(particles, params, counts); return;
+				case utils::simd::Level::AVX2:   detail::countDipoleSubCyclesAVX2(particles, params, counts); return;
+			#endif
+			default: detail::countDipoleSubCyclesScalar(particles, params, counts); return;
+		}
+	}
+
+	/**
+	 * Reorders the particles of the given store such that particles of the same species requiring
+	 * the same number of sub-cycles within the analytic dipole field are adjacent. Particles are
+	 * grouped by species first, in ascending order of their id, and by their number of sub-cycles
+	 * second, in ascending order. Thus, each species is pushed on its own by pushParticlesInDipoleField
+	 * and vectorized pushes process batches of (mostly) uniform trip counts. The relative order of
+	 * particles within a group is preserved, so stores which are already grouped are left unchanged.
+	 *
+	 * @param particles the particles to be grouped
+	 * @param params the field and time step parameters
+	 * @param level the instruction set extensions to be used, must be supported by the CPU
+	 */
+	template<typename T>
+	void groupParticlesBySubCycles(BasicParticleStore<T>& particles, const DipolePushParameters& params, utils::simd::Level level = utils::simd::getSupportedLevel()) {
+		const std::size_t size = particles.size();
+		if (size < 2) return;
+
+		// determine the sub-cycle class of each particle
+		utils::PooledVector<std::uint8_t> counts(size);
+		countSubCyclesInDipoleField(particles, params, counts.data(), level);
+
+		// combine species and sub-cycle class to the group of each particle
+		constexpr std::size_t numClasses = detail::maxDipoleSubCycles + 1;
+		const std::uint8_t* ids = particles.getSpeciesIds();
+		utils::PooledVector<std::uint16_t> groups(size);
+		for(std::size_t i = 0; i < size; ++i) {
+			groups[i] = std::uint16_t(ids[i] * numClasses + counts[i]);
+		}
+
+		// the particles moved since the last grouping, like the ones swapped by exports and appended by imports, usually
+		// break it; only if it is still intact, the particles do not need to be rearranged
+		if (std::is_sorted(groups.begin(), groups.end())) return;
+
+		// rearrange particles in place
+		reorderParticlesByKeys(particles, groups, particles.getSpecies().size() * numClasses);
+	}
+
+} // end namespace ipic3d
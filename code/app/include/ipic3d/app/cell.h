@@ -1,5 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
 #include <vector>
 #include <random>
 
@@ -11,9 +15,12 @@
 #include "allscale/utils/serializer.h"
 #include "allscale/utils/static_grid.h"
 
+#include "ipic3d/app/boris_pusher.h"
+#include "ipic3d/app/dipole_field.h"
 #include "ipic3d/app/field.h"
 #include "ipic3d/app/parameters.h"
 #include "ipic3d/app/particle.h"
+#include "ipic3d/app/particle_store.h"
 #include "ipic3d/app/transfer_buffer.h"
 #include "ipic3d/app/universe_properties.h"
 #include "ipic3d/app/utils/points.h"
@@ -30,13 +37,27 @@ namespace ipic3d {
 	 */
 	struct Cell {
 
-		// the list of local particles
-		std::vector<Particle> particles;
+		// the local particles
+		ParticleStore particles;
 
 	};
 
 	using Cells = allscale::api::user::data::Grid<Cell, 3>; // a 3D grid of cells
 
+	/**
+	 * Creates a grid of empty cells for a universe with the given properties. The particle
+	 * store of each cell maintains positions relative to the box covered by the cell.
+	 * @param properties the properties of the universe
+	 * @return the grid of cells
+	 */
+	Cells createCells(const UniverseProperties& properties) {
+		Cells cells(properties.size);
+		allscale::api::user::algorithm::pfor(properties.size, [&](const utils::Coordinate<3>& pos) {
+			cells[pos].particles.setFrame(getOriginOfCell(pos, properties), properties.cellWidth);
+		});
+		return cells;
+	}
+
 
 	/**
 	 * Tests whether a given particle is to be maintained by a cell of the given position.
@@ -495,7 +516,7 @@ namespace ipic3d {
 
 		// the 3-D grid of cells
 		auto gridSize = properties.size;
-		Cells cells(gridSize);
+		Cells cells = createCells(properties);
 
 		// get a private copy of the distribution generator
 		auto next = dist;
@@ -616,6 +637,7 @@ namespace ipic3d {
 
 			// get number of particles to be generated in this cell
 			auto localParticles = particleCount[flatten(pos)];
+			cell.particles.reserve(localParticles);
 
 			// generate particles
 			for(std::uint64_t i=0; i<localParticles; i++) {
@@ -640,7 +662,7 @@ namespace ipic3d {
 
 		// the 3-D grid of cells
 		auto gridSize = properties.size;
-		Cells cells(gridSize);
+		Cells cells = createCells(properties);
 
 		// just some info about the progress
 		std::cout << "Sorting in uniformly distributed particles ...\n";
@@ -686,6 +708,7 @@ namespace ipic3d {
 			}
 
 			// generate particles
+			cell.particles.reserve(numParticles);
 			for(std::uint64_t i=0; i<numParticles; i++) {
 				cell.particles.push_back(next());
 			}
@@ -702,22 +725,33 @@ namespace ipic3d {
 		// -- initialize the grid of cells --
 
 		// the 3-D grid of cells
-		Cells cells(properties.size);
+		Cells cells = createCells(properties);
 
 		// -- initialize the state of each individual cell --
 
-		// compute number of particles to be added for the uniform distribution
-		unsigned totalParticlesPerCell = initProperties.particlesPerCell[0].x * initProperties.particlesPerCell[0].y * initProperties.particlesPerCell[0].z;
-
 		const utils::Coordinate<3> zero = 0;							// a zero constant (coordinate [0,0,0])
 
-		// pre-compute values for computing q
-		double q_factor = params.qom[0] / fabs(params.qom[0]);
-		q_factor = q_factor * (properties.cellWidth.x * properties.cellWidth.y * properties.cellWidth.z) / totalParticlesPerCell;
-		const double fourPI = 16.0 * atan(1.0);
-		q_factor = q_factor * params.rhoInit[0] / fourPI;
+		// the number of species to be initialized
+		const std::size_t numSpecies = initProperties.particlesPerCell.size();
+		assert_le(numSpecies, std::size_t(params.ns));
+
+		// compute number of particles to be added for the uniform distribution of all species
+		std::vector<unsigned> totalParticlesPerCell(numSpecies);
+		unsigned totalParticlesOfAllSpecies = 0;
+		for(std::size_t s = 0; s < numSpecies; s++) {
+			const auto& particlesPerCell = initProperties.particlesPerCell[s];
+			totalParticlesPerCell[s] = particlesPerCell.x * particlesPerCell.y * particlesPerCell.z;
+			totalParticlesOfAllSpecies += totalParticlesPerCell[s];
+		}
 
-		auto particlesPerCell = initProperties.particlesPerCell[0];
+		// pre-compute values for computing q of each species
+		const double fourPI = 16.0 * atan(1.0);
+		std::vector<double> q_factors(numSpecies);
+		for(std::size_t s = 0; s < numSpecies; s++) {
+			double q_factor = params.qom[s] / fabs(params.qom[s]);
+			q_factor = q_factor * (properties.cellWidth.x * properties.cellWidth.y * properties.cellWidth.z) / totalParticlesPerCell[s];
+			q_factors[s] = q_factor * params.rhoInit[s] / fourPI;
+		}
 
 		// TODO: return this as a treeture
 		allscale::api::user::algorithm::pfor(zero, properties.size, [=,&cells](const utils::Coordinate<3>& pos) {
@@ -726,45 +760,48 @@ namespace ipic3d {
 			auto cellOrigin = getOriginOfCell(pos, properties);
 
 			// add the requested number of parameters
+			cell.particles.reserve(totalParticlesOfAllSpecies);
 			std::minstd_rand randGenerator((unsigned)(pos[0] * 10000 + pos[1] * 100 + pos[2]));
 			const double randMax = std::minstd_rand::max();
 
 			// -- add particles --
 			// TODO: we plan to can use bags to store particle which would allow us to parallelize this for loop
-			// Maxellian random velocity and uniform spatial distribution
-			// To note: this is for one specie
-			for (unsigned i = 0; i < particlesPerCell.x; i++) {
-				for (unsigned j = 0; j < particlesPerCell.y; j++) {
-					for (unsigned k = 0; k < particlesPerCell.z; k++) {
-						Particle p;
-
-						// initialize particle's position
-						p.position.x = (i + 0.5) * (properties.cellWidth.x / particlesPerCell.x) + cellOrigin.x;
-						p.position.y = (j + 0.5) * (properties.cellWidth.y / particlesPerCell.y) + cellOrigin.y;
-						p.position.z = (k + 0.5) * (properties.cellWidth.z / particlesPerCell.z) + cellOrigin.z;
-
-						// initialize particle's velocity
-						double prob0, prob1;
-						double theta0, theta1;
-
-						double harvest = (double)randGenerator() / randMax;
-						prob0 = sqrt( -2.0 * log( 1.0 - 0.999999 * harvest ) );
-						harvest = (double)randGenerator() / randMax;
-						theta0 = 2.0 * M_PI * harvest;
-
-						harvest = (double)randGenerator() / randMax;
-						prob1 = sqrt( -2.0 * log( 1.0 - 0.999999 * harvest ) );
-						harvest = (double)randGenerator() / randMax;
-						theta1 = 2.0 * M_PI * harvest;
-
-						p.velocity.x = params.u0[0] + params.uth[0] * ( prob0 * cos(theta0) );
-						p.velocity.y = params.v0[0] + params.vth[0] * ( prob0 * sin(theta0) );
-						p.velocity.z = params.w0[0] + params.wth[0] * ( prob1 * cos(theta1) );
-
-						p.qom = params.qom[0];
-						p.q = q_factor;
-
-						cell.particles.push_back(p);
+			// Maxellian random velocity and uniform spatial distribution, one species after the other
+			for (std::size_t s = 0; s < numSpecies; s++) {
+				const auto& particlesPerCell = initProperties.particlesPerCell[s];
+				for (unsigned i = 0; i < particlesPerCell.x; i++) {
+					for (unsigned j = 0; j < particlesPerCell.y; j++) {
+						for (unsigned k = 0; k < particlesPerCell.z; k++) {
+							Particle p;
+
+							// initialize particle's position
+							p.position.x = (i + 0.5) * (properties.cellWidth.x / particlesPerCell.x) + cellOrigin.x;
+							p.position.y = (j + 0.5) * (properties.cellWidth.y / particlesPerCell.y) + cellOrigin.y;
+							p.position.z = (k + 0.5) * (properties.cellWidth.z / particlesPerCell.z) + cellOrigin.z;
+
+							// initialize particle's velocity
+							double prob0, prob1;
+							double theta0, theta1;
+
+							double harvest = (double)randGenerator() / randMax;
+							prob0 = sqrt( -2.0 * log( 1.0 - 0.999999 * harvest ) );
+							harvest = (double)randGenerator() / randMax;
+							theta0 = 2.0 * M_PI * harvest;
+
+							harvest = (double)randGenerator() / randMax;
+							prob1 = sqrt( -2.0 * log( 1.0 - 0.999999 * harvest ) );
+							harvest = (double)randGenerator() / randMax;
+							theta1 = 2.0 * M_PI * harvest;
+
+							p.velocity.x = params.u0[s] + params.uth[s] * ( prob0 * cos(theta0) );
+							p.velocity.y = params.v0[s] + params.vth[s] * ( prob0 * sin(theta0) );
+							p.velocity.z = params.w0[s] + params.wth[s] * ( prob1 * cos(theta1) );
+
+							p.qom = params.qom[s];
+							p.q = q_factors[s];
+
+							cell.particles.push_back(p);
+						}
 					}
 				}
 			}
@@ -776,13 +813,16 @@ namespace ipic3d {
 	}
 
 	/**
-	* This function projects the effect of the particles contained in the specified cell
-	* to the given density contributions defined on the grid
+	* This function projects the effect of the particles contained in the 8 cells around the
+	* node at the given position to the current density on that node. It gathers the particles
+	* of all adjacent cells, thus each particle is visited once for each of its 8 nodes; for
+	* computing the density on all nodes, see the overload depositing the particles of each
+	* cell once.
 	*
 	* @param universeProperties the properties of this universe
-	* @param cell the cell whose particles are considered in the density contributions computation
-	* @param pos the coordinates of this cell in the grid
-	* @param contributions the density contributions output
+	* @param cells the cells whose particles are considered in the density computation
+	* @param pos the coordinates of the node in the density grid
+	* @param density the current density output
 	*/
 	void projectToDensityField(const UniverseProperties& universeProperties, const Cells& cells, const utils::Coordinate<3>& pos, CurrentDensity& density) {
 
@@ -804,16 +844,26 @@ namespace ipic3d {
 					cur[1] = adjustPosition(1);
 					cur[2] = adjustPosition(2);
 
-					const auto cellOrigin = getOriginOfCell(cur, universeProperties);
-					for(const auto& p : cells[cur].particles) {
-						// get the fractional distance of the particle from the cell origin
-						const auto relPos = allscale::utils::elementwiseDivision((p.position - cellOrigin), (universeProperties.cellWidth));
+					// particles are stored relative to their cell, providing the fractional distance from the cell origin
+					const auto& particles = cells[cur].particles;
+					assert_true(particles.getFrameOrigin() == getOriginOfCell(cur, universeProperties)) << "Cell " << cur << " is not using its own frame";
+					const auto* px = particles.data(ParticleStore::X);
+					const auto* py = particles.data(ParticleStore::Y);
+					const auto* pz = particles.data(ParticleStore::Z);
+					const auto* pvx = particles.data(ParticleStore::VX);
+					const auto* pvy = particles.data(ParticleStore::VY);
+					const auto* pvz = particles.data(ParticleStore::VZ);
+					const auto* ids = particles.getSpeciesIds();
+					const auto& species = particles.getSpecies();
+					for(std::size_t index = 0; index < particles.size(); ++index) {
+						const Vector3<double> relPos { px[index], py[index], pz[index] };
+						const Vector3<double> velocity { pvx[index], pvy[index], pvz[index] };
 
 						// computation of J also includes weights from the particles as for E
 						// despite the fact that we are working right now with multiple cells, so the position of J would be different
 						// 	the formula still works well as it captures position of J in each of those cells.
 						auto fac = (i == 0 ? (1 - relPos.x) : relPos.x) * (j == 0 ? (1 - relPos.y) : relPos.y) * (k == 0 ? (1 - relPos.z) : relPos.z);
-						Js += p.q * p.velocity * fac;
+						Js += species[ids[index]].q * velocity * fac;
 					}
 				}
 			}
@@ -825,33 +875,249 @@ namespace ipic3d {
 
 
 	/**
-	* This function aggregates the density contributions into the current density on the nodes
+	* This function deposits the current of the particles of the given cell onto the 8 nodes at its
+	* corners, adding the contributions, scaled by the given factor, to the given corner values.
 	*
 	* @param universeProperties the properties of this universe
-	* @param densityContributions the density contributions
-	* @param pos the coordinates of this current density on the grid
-	* @param density the current density output
+	* @param cell the cell whose particles are deposited
+	* @param pos the coordinates of this cell in the grid
+	* @param corners the current density at the corners of the cell, indexed by their offset, the contributions are added to
+	* @param factor the factor the contributions are scaled with
 	*/
-	void aggregateDensityContributions(const UniverseProperties& universeProperties, const CurrentDensity& densityContributions, const utils::Coordinate<3>& pos, DensityNode& density) {
+	void depositCurrentDensity(const UniverseProperties& universeProperties, const Cell& cell, const utils::Coordinate<3>& pos, Vector3<double> (&corners)[2][2][2], double factor = 1.0) {
+
+		// particles are stored relative to their cell, providing the interpolation weights
+		const auto& particles = cell.particles;
+		if (particles.empty()) return;
+		assert_true(particles.getFrameOrigin() == getOriginOfCell(pos, universeProperties)) << "Cell " << pos << " is not using its own frame";
+
+		const auto* px = particles.data(ParticleStore::X);
+		const auto* py = particles.data(ParticleStore::Y);
+		const auto* pz = particles.data(ParticleStore::Z);
+		const auto* pvx = particles.data(ParticleStore::VX);
+		const auto* pvy = particles.data(ParticleStore::VY);
+		const auto* pvz = particles.data(ParticleStore::VZ);
+		const auto* ids = particles.getSpeciesIds();
+		const auto& species = particles.getSpecies();
+
+		// accumulate the contributions to the corners of the cell locally, each particle being read once
+		Vector3<double> Js[2][2][2];
+		for(int i=0; i<2; i++) {
+			for(int j=0; j<2; j++) {
+				for(int k=0; k<2; k++) {
+					Js[i][j][k] = Vector3<double>(0.0);
+				}
+			}
+		}
 
-		auto size = densityContributions.size();
-		auto curDensityContributionPos = pos * 2;
+		for(std::size_t index = 0; index < particles.size(); ++index) {
+			const Vector3<double> relPos { px[index], py[index], pz[index] };
+			const Vector3<double> current = species[ids[index]].q * Vector3<double>{ pvx[index], pvy[index], pvz[index] };
+			for(int i=0; i<2; i++) {
+				const double wx = (i == 0 ? (1 - relPos.x) : relPos.x);
+				for(int j=0; j<2; j++) {
+					const double wxy = wx * (j == 0 ? (1 - relPos.y) : relPos.y);
+					for(int k=0; k<2; k++) {
+						Js[i][j][k] += current * (wxy * (k == 0 ? (1 - relPos.z) : relPos.z));
+					}
+				}
+			}
+		}
 
-		for(int i = 0; i < 2; ++i) {
-			for(int j = 0; j < 2; ++j) {
-				for(int k = 0; k < 2; ++k) {
-					utils::Coordinate<3> cur = curDensityContributionPos + utils::Coordinate<3>{i - 1, j - 1, k - 1};
-					if(cur[0] < 0 || cur[0] >= size[0]) continue;
-					if(cur[1] < 0 || cur[1] >= size[1]) continue;
-					if(cur[2] < 0 || cur[2] >= size[2]) continue;
+		for(int i=0; i<2; i++) {
+			for(int j=0; j<2; j++) {
+				for(int k=0; k<2; k++) {
+					corners[i][j][k] += Js[i][j][k] * factor;
+				}
+			}
+		}
+	}
+
+	/**
+	* The default width of the cubic tiles of cells accumulating their deposits in private buffers, see projectToDensityField.
+	*/
+	constexpr std::int64_t depositionTileWidth = 8;
+
+	namespace detail {
+
+		/**
+		 * Projects a quantity of the particles of all cells of a periodic universe of the given size onto the nodes
+		 * at the corners of the cells, storing the result in the given member of the nodes of the given grid, which
+		 * covers size+1 nodes along each dimension. In a first parallel loop, the cells of each cubic tile of the given
+		 * width add the contributions to their corners, obtained by the given deposit operation, to a buffer private to
+		 * their tile, covering its nodes. In a second one, each node sums the buffers of the (up to 8) tiles sharing it,
+		 * including the ones of its periodic images on the opposite boundary, which coincide with it. Thus, the grid is
+		 * neither cleared nor merged at the boundaries in separate passes.
+		 */
+		template<typename T, typename Value, typename Deposit>
+		void projectByTiles(const utils::Size<3>& size, std::int64_t tileWidth, allscale::api::user::data::Grid<T,3>& density, Value T::* member, const Deposit& deposit) {
+			using allscale::api::user::algorithm::pfor;
+			assert_lt(0, tileWidth);
+			assert_true(density.size() == size + utils::Coordinate<3>(1)) << "Expected density grid of size " << (size + utils::Coordinate<3>(1)) << " but got " << density.size();
+
+			// the private buffers of all tiles, each covering the (tileWidth+1)^3 nodes of its cells
+			const auto zero = utils::Coordinate<3>(0);
+			const auto numTiles = utils::getNumBlocks(zero, size, tileWidth);
+			const std::int64_t stride = tileWidth + 1;
+			const std::size_t bufferSize = std::size_t(stride * stride * stride);
+			std::vector<Value> buffers(std::size_t(numTiles.x * numTiles.y * numTiles.z) * bufferSize);
+			auto getBuffer = [&](const utils::Coordinate<3>& tile) {
+				return &buffers[std::size_t((tile.x * numTiles.y + tile.y) * numTiles.z + tile.z) * bufferSize];
+			};
+			auto getIndex = [stride](const utils::Coordinate<3>& local) {
+				return std::size_t((local.x * stride + local.y) * stride + local.z);
+			};
+
+			// accumulate the deposits of the cells of each tile in its buffer
+			utils::pforBlocks(zero, size, tileWidth, [&](const utils::Coordinate<3>& low, const utils::Coordinate<3>& high) {
+				utils::Coordinate<3> tile;
+				for(int d = 0; d < 3; ++d) {
+					tile[d] = low[d] / tileWidth;
+				}
+				Value* buffer = getBuffer(tile);
+				std::fill(buffer, buffer + bufferSize, Value(0.0));
+				utils::forEachInMortonOrder(low, high, [&](const utils::Coordinate<3>& pos) {
+					Value corners[2][2][2];
+					for(int i=0; i<2; i++) {
+						for(int j=0; j<2; j++) {
+							for(int k=0; k<2; k++) {
+								corners[i][j][k] = Value(0.0);
+							}
+						}
+					}
+					deposit(pos, corners);
+					const auto local = pos - low;
+					for(int i=0; i<2; i++) {
+						for(int j=0; j<2; j++) {
+							for(int k=0; k<2; k++) {
+								buffer[getIndex(local + utils::Coordinate<3>{i,j,k})] += corners[i][j][k];
+							}
+						}
+					}
+				});
+			});
+
+			// sum the buffers of the tiles sharing each node
+			pfor(zero, density.size(), [&](const utils::Coordinate<3>& pos) {
+
+				// along each dimension, a node is located in the tile covering it as a lower corner of a cell and, at the
+				// lower boundary of a tile, in the preceding tile as an upper corner; nodes on the upper boundary of the
+				// universe coincide with the ones on the lower boundary
+				std::array<std::array<std::int64_t,2>,3> tiles;
+				std::array<std::array<std::int64_t,2>,3> offsets;
+				std::array<int,3> counts;
+				for(int d = 0; d < 3; ++d) {
+					const std::int64_t node = (pos[d] == size[d]) ? 0 : pos[d];
+					const std::int64_t tile = node / tileWidth;
+					tiles[d][0] = tile;
+					offsets[d][0] = node - tile * tileWidth;
+					counts[d] = 1;
+					if (offsets[d][0] == 0) {
+						const std::int64_t prev = (tile > 0) ? tile - 1 : numTiles[d] - 1;
+						tiles[d][1] = prev;
+						offsets[d][1] = std::min(size[d] - prev * tileWidth, tileWidth);
+						counts[d] = 2;
+					}
+				}
 
-					density.J += densityContributions[cur].J;
+				Value sum(0.0);
+				for(int i = 0; i < counts[0]; ++i) {
+					for(int j = 0; j < counts[1]; ++j) {
+						for(int k = 0; k < counts[2]; ++k) {
+							const Value* buffer = getBuffer({ tiles[0][i], tiles[1][j], tiles[2][k] });
+							sum += buffer[getIndex({ offsets[0][i], offsets[1][j], offsets[2][k] })];
+						}
+					}
+				}
+				density[pos].*member = sum;
+			});
+		}
+
+	}
+
+	/**
+	* This function projects the effect of the particles of all cells to the current density defined
+	* on the nodes of the grid, yielding the same result as evaluating the node-wise projectToDensityField
+	* for every node (up to rounding errors). Instead of gathering the particles of the 8 cells around
+	* each node, the particles of each cell are deposited once onto the nodes at the corners of their
+	* cell, already normalized, into a buffer private to the tile of cells containing it; a single
+	* reduction then sums the buffers sharing each node directly into the given density grid, also
+	* merging the nodes on opposite boundaries of the periodic universe.
+	*
+	* @param universeProperties the properties of this universe
+	* @param cells the cells whose particles are projected
+	* @param density the current density output, covering the nodes of all cells
+	* @param tileWidth the width of the cubic tiles of cells sharing a private buffer
+	*/
+	void projectToDensityField(const UniverseProperties& universeProperties, const Cells& cells, CurrentDensity& density, std::int64_t tileWidth = depositionTileWidth) {
+		const double vol = universeProperties.cellWidth.x * universeProperties.cellWidth.y * universeProperties.cellWidth.z;
+		const double factor = 1.0 / (vol * 8.0);
+		detail::projectByTiles(universeProperties.size, tileWidth, density, &DensityNode::J, [&](const utils::Coordinate<3>& pos, Vector3<double> (&corners)[2][2][2]) {
+			depositCurrentDensity(universeProperties, cells[pos], pos, corners, factor);
+		});
+	}
+
+	/**
+	* This function deposits the charge of the particles of the given cell onto the 8 nodes at its
+	* corners, using the same weights as depositCurrentDensity.
+	*
+	* @param universeProperties the properties of this universe
+	* @param cell the cell whose particles are deposited
+	* @param pos the coordinates of this cell in the grid
+	* @param corners the charge density at the corners of the cell, indexed by their offset, the contributions are added to
+	* @param factor the factor the contributions are scaled with
+	*/
+	void depositChargeDensity(const UniverseProperties& universeProperties, const Cell& cell, const utils::Coordinate<3>& pos, double (&corners)[2][2][2], double factor = 1.0) {
+		const auto& particles = cell.particles;
+		if (particles.empty()) return;
+		assert_true(particles.getFrameOrigin() == getOriginOfCell(pos, universeProperties)) << "Cell " << pos << " is not using its own frame";
+
+		const auto* px = particles.data(ParticleStore::X);
+		const auto* py = particles.data(ParticleStore::Y);
+		const auto* pz = particles.data(ParticleStore::Z);
+		const auto* ids = particles.getSpeciesIds();
+		const auto& species = particles.getSpecies();
+
+		double rho[2][2][2] = {};
+		for(std::size_t index = 0; index < particles.size(); ++index) {
+			const double q = species[ids[index]].q;
+			for(int i=0; i<2; i++) {
+				const double wx = q * (i == 0 ? (1 - px[index]) : px[index]);
+				for(int j=0; j<2; j++) {
+					const double wxy = wx * (j == 0 ? (1 - py[index]) : py[index]);
+					for(int k=0; k<2; k++) {
+						rho[i][j][k] += wxy * (k == 0 ? (1 - pz[index]) : pz[index]);
+					}
 				}
 			}
 		}
 
+		for(int i=0; i<2; i++) {
+			for(int j=0; j<2; j++) {
+				for(int k=0; k<2; k++) {
+					corners[i][j][k] += rho[i][j][k] * factor;
+				}
+			}
+		}
+	}
+
+	/**
+	* This function projects the charge of the particles of all cells to the charge density defined on
+	* the nodes of the grid, normalized like the current density, see projectToDensityField. Thus, the
+	* continuity equation holds for the pair of them, and, in the units of the field solvers,
+	* Gauss's law reads div E = rho.
+	*
+	* @param universeProperties the properties of this universe
+	* @param cells the cells whose particles are projected
+	* @param density the charge density output, covering the nodes of all cells
+	* @param tileWidth the width of the cubic tiles of cells sharing a private buffer
+	*/
+	void projectToChargeDensity(const UniverseProperties& universeProperties, const Cells& cells, ChargeDensity& density, std::int64_t tileWidth = depositionTileWidth) {
 		const double vol = universeProperties.cellWidth.x * universeProperties.cellWidth.y * universeProperties.cellWidth.z;
-		density.J = density.J / vol / 8.0; // divide by 8 to average the value contributed by 8 neighboring cells
+		const double factor = 1.0 / (vol * 8.0);
+		detail::projectByTiles(universeProperties.size, tileWidth, density, &ChargeDensityNode::rho, [&](const utils::Coordinate<3>& pos, double (&corners)[2][2][2]) {
+			depositChargeDensity(universeProperties, cells[pos], pos, corners, factor);
+		});
 	}
 
 	/**
@@ -884,6 +1150,19 @@ namespace ipic3d {
 		return res / vol;
 	}
 
+	/**
+	 * Obtains the parameters for pushing particles through the dipole field of the planet
+	 * for a single time step of the given universe.
+	 */
+	DipolePushParameters getDipolePushParameters(const UniverseProperties& properties) {
+		DipolePushParameters params;
+		params.magneticFieldTemp = DipoleField(properties.externalMagneticField, properties.planetRadius).getFactor();
+		params.E = { 0.0, 0.0, 0.0 };
+		params.dt = properties.dt;
+		params.speedOfLight = properties.speedOfLight;
+		return params;
+	}
+
 	/**
 	 * This function updates the position of all particles within a cell for a single
 	 * time step, considering the given field as a driving force.
@@ -920,242 +1199,285 @@ namespace ipic3d {
 
 		//double vol = properties.cellWidth.x * properties.cellWidth.y * properties.cellWidth.z;
 
-		double magneticFieldTemp = -properties.externalMagneticField.z * pow(properties.planetRadius, 3);
-
 		// update particles
-//		allscale::api::user::algorithm::pfor(cell.particles, [&](Particle& p){
-		for(std::size_t i = 0; i < cell.particles.size(); ++i) {
-			Particle& p = cell.particles[i];
-			// Docu: https://www.particleincell.com/2011/vxb-rotation/
-			// Code: https://www.particleincell.com/wp-content/uploads/2011/07/ParticleIntegrator.java
-
-//			// get the fractional distance of the particle from the cell origin
-//			const auto relPos = allscale::utils::elementwiseDivision((p.position - cellOrigin), (properties.cellWidth));
+		// Docu: https://www.particleincell.com/2011/vxb-rotation/
+		// Code: https://www.particleincell.com/wp-content/uploads/2011/07/ParticleIntegrator.java
+
+//		// get the fractional distance of the particle from the cell origin
+//		const auto relPos = allscale::utils::elementwiseDivision((p.position - cellOrigin), (properties.cellWidth));
 //
-//			// interpolate
-//			auto E = trilinearInterpolationF2P(Es, relPos, vol);
-//			auto B = trilinearInterpolationF2P(Bs, relPos, vol);
-
-			// calculate 3 Cartesian components of the magnetic field
-			double fac1 =  magneticFieldTemp / pow(allscale::utils::sumOfSquares(p.position), 2.5);
-			Vector3<double> E, B;
-			E = {0.0, 0.0, 0.0};
-			B.x = 3.0 * p.position.x * p.position.z * fac1;
-			B.y = 3.0 * p.position.y * p.position.z * fac1;
-			B.z = (2.0 * pow(p.position.z, 2) - pow(p.position.x, 2) - pow(p.position.y, 2)) * fac1;
-
-			// adaptive sub-cycling for computing velocity
-			double B_mag = allscale::utils::sumOfSquares(B);
-			double dt_sub = M_PI * properties.speedOfLight / (4.0 * fabs(p.qom) * B_mag);
-			int sub_cycles = int(properties.dt / dt_sub) + 1;
-			sub_cycles = std::min(sub_cycles, 100);
-			dt_sub = properties.dt / double(sub_cycles);
-
-			for (int cyc_cnt = 0; cyc_cnt < sub_cycles; cyc_cnt++) {
-				// update velocity
-				p.updateVelocity(E, B, dt_sub);
-
-				// update position
-				p.updatePosition(dt_sub);
-			}
-		}
-//		});
+//		// interpolate
+//		auto E = trilinearInterpolationF2P(Es, relPos, vol);
+//		auto B = trilinearInterpolationF2P(Bs, relPos, vol);
+
+		// push all particles through the dipole field, using the vector units of the CPU
+		pushParticlesInDipoleField(cell.particles, getDipolePushParameters(properties));
 
 	}
 
 	/**
-	* This function extracts all particles which are no longer in the domain of the
-	* given cell and inserts them into the provided transfer buffers.
-	*
-	* @param universeProperties the properties of this universe
-	* @param cell the cell whose particles are moved
-	* @param pos the coordinates of this cell in the grid
-	* @param transfers a grid of buffers to send particles to
-	*/
-	void exportParticles(const UniverseProperties& universeProperties, Cell& cell, const utils::Coordinate<3>& pos, TransferBuffers& transfers) {
-
-		assert_true(pos.dominatedBy(universeProperties.size)) << "Position " << pos << " is outside universe of size " << universeProperties.size;
-
-		// -- migrate particles to other cells if boundaries are crossed --
-
-		// create buffer of remaining particles
-		std::vector<Particle> remaining;
-		remaining.reserve(cell.particles.size());
-
-		{
-
-			auto size = universeProperties.size;
-
-			std::vector<Particle>* neighbors[3][3][3];
-
-			// NOTE: due to an unimplemented feature in the analysis, this loop needs to be unrolled (work in progress)
-
-			//			for(int i = 0; i<3; i++) {
-			//				for(int j = 0; j<3; j++) {
-			//					for(int k = 0; k<3; k++) {
-			//
-			//						// get neighbor cell in this direction (including wrap-around)
-			//						auto neighbor = (pos + utils::Coordinate<3>{ i-1, j-1, k-1 } + size) % size;
-			//
-			//						// index this buffer to the neighboring cell
-			//						auto& buffer = transfers.getBuffer(neighbor,TransferDirection{ 2-i, 2-j, 2-k });
-			//						neighbors[i][j][k] = &buffer;
-			//
-			//						// clear buffer from particles moved in the last iteration
-			//						buffer.clear();
-			//					}
-			//				}
-			//			}
-
-			// -- unroll begin --
-
-			neighbors[0][0][0] = &transfers.getBuffer((pos + utils::Coordinate<3>{ -1, -1, -1 } +size) % size, TransferDirection{ 2, 2, 2 });
-			neighbors[0][0][1] = &transfers.getBuffer((pos + utils::Coordinate<3>{ -1, -1, 0 } +size) % size, TransferDirection{ 2, 2, 1 });
-			neighbors[0][0][2] = &transfers.getBuffer((pos + utils::Coordinate<3>{ -1, -1, 1 } +size) % size, TransferDirection{ 2, 2, 0 });
+	 * This function updates the position of all particles within a cell for a single
+	 * time step like moveParticles, yet groups the particles of the cell by species and
+	 * the number of sub-cycles they require first. Thus, each species is pushed on its
+	 * own and the particles processed by each vector instruction share the same sub-cycle
+	 * count, avoiding idle lanes in cells of strongly varying field strength (e.g. close
+	 * to the planet) and sparing heavy species the sub-cycles of the electrons.
+	 *
+	 * @param properties the properties of this universe
+	 * @param cell the cell whose particles are moved
+	 * @param pos the coordinates of this cell in the grid
+	 * @param field the most recently computed state of the surrounding force fields
+	 */
+	void moveParticlesGroupedBySubCycles(const UniverseProperties& properties, Cell& cell, const utils::Coordinate<3>& pos, const Field& /*field*/) {
 
-			neighbors[0][1][0] = &transfers.getBuffer((pos + utils::Coordinate<3>{ -1, 0, -1 } +size) % size, TransferDirection{ 2, 1, 2 });
-			neighbors[0][1][1] = &transfers.getBuffer((pos + utils::Coordinate<3>{ -1, 0, 0 } +size) % size, TransferDirection{ 2, 1, 1 });
-			neighbors[0][1][2] = &transfers.getBuffer((pos + utils::Coordinate<3>{ -1, 0, 1 } +size) % size, TransferDirection{ 2, 1, 0 });
+		assert_true(pos.dominatedBy(properties.size)) << "Position " << pos << " is outside universe of size " << properties.size;
 
-			neighbors[0][2][0] = &transfers.getBuffer((pos + utils::Coordinate<3>{ -1, 1, -1 } +size) % size, TransferDirection{ 2, 0, 2 });
-			neighbors[0][2][1] = &transfers.getBuffer((pos + utils::Coordinate<3>{ -1, 1, 0 } +size) % size, TransferDirection{ 2, 0, 1 });
-			neighbors[0][2][2] = &transfers.getBuffer((pos + utils::Coordinate<3>{ -1, 1, 1 } +size) % size, TransferDirection{ 2, 0, 0 });
+		// quick-check
+		if (cell.particles.empty()) return;
 
+		auto params = getDipolePushParameters(properties);
+		groupParticlesBySubCycles(cell.particles, params);
+		pushParticlesInDipoleField(cell.particles, params);
+	}
 
-			neighbors[1][0][0] = &transfers.getBuffer((pos + utils::Coordinate<3>{  0, -1, -1 } +size) % size, TransferDirection{ 1, 2, 2 });
-			neighbors[1][0][1] = &transfers.getBuffer((pos + utils::Coordinate<3>{  0, -1, 0 } +size) % size, TransferDirection{ 1, 2, 1 });
-			neighbors[1][0][2] = &transfers.getBuffer((pos + utils::Coordinate<3>{  0, -1, 1 } +size) % size, TransferDirection{ 1, 2, 0 });
+	/**
+	 * Obtains the parameters for pushing the particles of the cell at the given position through
+	 * the given field, gathering the field nodes at the 8 corners of the cell.
+	 */
+	FieldPushParameters getFieldPushParameters(const UniverseProperties& properties, const utils::Coordinate<3>& pos, const Field& field) {
+		FieldPushParameters params;
+		for(int i=0; i<2; i++) {
+			for(int j=0; j<2; j++) {
+				for(int k=0; k<2; k++) {
+					// the field has a ghost layer of nodes at its lower boundary
+					utils::Coordinate<3> cur({pos[0]+i+1,pos[1]+j+1,pos[2]+k+1});
+					params.E[i][j][k] = field[cur].E;
+					params.B[i][j][k] = field[cur].B;
+				}
+			}
+		}
+		params.dt = properties.dt;
+		return params;
+	}
 
-			neighbors[1][1][0] = &transfers.getBuffer((pos + utils::Coordinate<3>{  0, 0, -1 } +size) % size, TransferDirection{ 1, 1, 2 });
-			neighbors[1][1][1] = &transfers.getBuffer((pos + utils::Coordinate<3>{  0, 0, 0 } +size) % size, TransferDirection{ 1, 1, 1 });
-			neighbors[1][1][2] = &transfers.getBuffer((pos + utils::Coordinate<3>{  0, 0, 1 } +size) % size, TransferDirection{ 1, 1, 0 });
+	/**
+	 * This function updates the position of all particles within a cell for a single
+	 * time step, interpolating the electric and magnetic field at the position of each
+	 * particle from the field nodes at the corners of the cell. Unlike moveParticles,
+	 * the field model is thus determined by the given field, not by the analytic dipole.
+	 *
+	 * @param properties the properties of this universe
+	 * @param cell the cell whose particles are moved
+	 * @param pos the coordinates of this cell in the grid
+	 * @param field the most recently computed state of the surrounding force fields
+	 */
+	void moveParticlesInField(const UniverseProperties& properties, Cell& cell, const utils::Coordinate<3>& pos, const Field& field) {
 
-			neighbors[1][2][0] = &transfers.getBuffer((pos + utils::Coordinate<3>{  0, 1, -1 } +size) % size, TransferDirection{ 1, 0, 2 });
-			neighbors[1][2][1] = &transfers.getBuffer((pos + utils::Coordinate<3>{  0, 1, 0 } +size) % size, TransferDirection{ 1, 0, 1 });
-			neighbors[1][2][2] = &transfers.getBuffer((pos + utils::Coordinate<3>{  0, 1, 1 } +size) % size, TransferDirection{ 1, 0, 0 });
+		assert_true(pos.dominatedBy(properties.size)) << "Position " << pos << " is outside universe of size " << properties.size;
 
+		// quick-check
+		if (cell.particles.empty()) return;
 
-			neighbors[2][0][0] = &transfers.getBuffer((pos + utils::Coordinate<3>{  1, -1, -1 } +size) % size, TransferDirection{ 0, 2, 2 });
-			neighbors[2][0][1] = &transfers.getBuffer((pos + utils::Coordinate<3>{  1, -1, 0 } +size) % size, TransferDirection{ 0, 2, 1 });
-			neighbors[2][0][2] = &transfers.getBuffer((pos + utils::Coordinate<3>{  1, -1, 1 } +size) % size, TransferDirection{ 0, 2, 0 });
+		// particles are stored relative to this cell, thus their positions are their interpolation weights
+		assert_true(cell.particles.getFrameOrigin() == getOriginOfCell(pos, properties)) << "Cell " << pos << " is not using its own frame";
+		assert_true(cell.particles.getFrameWidth() == properties.cellWidth) << "Cell " << pos << " is not using its own frame";
 
-			neighbors[2][1][0] = &transfers.getBuffer((pos + utils::Coordinate<3>{  1, 0, -1 } +size) % size, TransferDirection{ 0, 1, 2 });
-			neighbors[2][1][1] = &transfers.getBuffer((pos + utils::Coordinate<3>{  1, 0, 0 } +size) % size, TransferDirection{ 0, 1, 1 });
-			neighbors[2][1][2] = &transfers.getBuffer((pos + utils::Coordinate<3>{  1, 0, 1 } +size) % size, TransferDirection{ 0, 1, 0 });
+		pushParticlesInInterpolatedField(cell.particles, getFieldPushParameters(properties, pos, field));
+	}
 
-			neighbors[2][2][0] = &transfers.getBuffer((pos + utils::Coordinate<3>{  1, 1, -1 } +size) % size, TransferDirection{ 0, 0, 2 });
-			neighbors[2][2][1] = &transfers.getBuffer((pos + utils::Coordinate<3>{  1, 1, 0 } +size) % size, TransferDirection{ 0, 0, 1 });
-			neighbors[2][2][2] = &transfers.getBuffer((pos + utils::Coordinate<3>{  1, 1, 1 } +size) % size, TransferDirection{ 0, 0, 0 });
+	namespace detail {
 
-			neighbors[0][0][0]->clear();
-			neighbors[0][0][1]->clear();
-			neighbors[0][0][2]->clear();
+		/**
+		 * Exports the particles leaving the given cell, handing particles moving to a cell
+		 * provided by the given function directly over to that cell. Other particles are
+		 * inserted into the transfer buffer of the given cell.
+		 */
+		template<typename LocalCells>
+		void exportLeavingParticles(const UniverseProperties& universeProperties, Cell& cell, const utils::Coordinate<3>& pos, TransferBuffers& transfers, const LocalCells& getLocalCell) {
 
-			neighbors[0][1][0]->clear();
-			neighbors[0][1][1]->clear();
-			neighbors[0][1][2]->clear();
+			assert_true(pos.dominatedBy(universeProperties.size)) << "Position " << pos << " is outside universe of size " << universeProperties.size;
 
-			neighbors[0][2][0]->clear();
-			neighbors[0][2][1]->clear();
-			neighbors[0][2][2]->clear();
+			// -- migrate particles to other cells if boundaries are crossed --
 
+			auto size = universeProperties.size;
 
-			neighbors[1][0][0]->clear();
-			neighbors[1][0][1]->clear();
-			neighbors[1][0][2]->clear();
+			// particles are stored relative to this cell, covering [0,1] in each dimension
+			auto& particles = cell.particles;
+			assert_true(particles.getFrameOrigin() == getOriginOfCell(pos, universeProperties)) << "Cell " << pos << " is not using its own frame";
 
-			neighbors[1][1][0]->clear();
-			neighbors[1][1][1]->clear();
-			neighbors[1][1][2]->clear();
+			auto* px = particles.data(ParticleStore::X);
+			auto* py = particles.data(ParticleStore::Y);
+			auto* pz = particles.data(ParticleStore::Z);
+			auto* pvx = particles.data(ParticleStore::VX);
+			auto* pvy = particles.data(ParticleStore::VY);
+			auto* pvz = particles.data(ParticleStore::VZ);
 
-			neighbors[1][2][0]->clear();
-			neighbors[1][2][1]->clear();
-			neighbors[1][2][2]->clear();
+			const auto cellOrigin = particles.getFrameOrigin();
+			const auto& width = universeProperties.cellWidth;
+			const double planetRadius2 = universeProperties.planetRadius * universeProperties.planetRadius;
 
+			// cells at the boundary of the universe reflect particles leaving the universe
+			const bool reflectLow[3] = { pos[0] == 0, pos[1] == 0, pos[2] == 0 };
+			const bool reflectHigh[3] = { pos[0] == size[0] - 1, pos[1] == size[1] - 1, pos[2] == size[2] - 1 };
 
-			neighbors[2][0][0]->clear();
-			neighbors[2][0][1]->clear();
-			neighbors[2][0][2]->clear();
+			// the direction a particle is leaving in, or removed for particles to be dropped
+			const unsigned removed = TransferDirection::NumDirections;
+			const unsigned center = TransferDirection(1, 1, 1).getIndex();
 
-			neighbors[2][1][0]->clear();
-			neighbors[2][1][1]->clear();
-			neighbors[2][1][2]->clear();
+			// particles remaining in cells not touching the planet can not be absorbed
+			const bool absorbing = intersectsPlanet(pos, universeProperties);
 
-			neighbors[2][2][0]->clear();
-			neighbors[2][2][1]->clear();
-			neighbors[2][2][2]->clear();
+			auto getTarget = [&](std::size_t index) {
 
-			// -- unroll end --
+				// send particle to neighboring cell if required
+				int i = (px[index] < 0.0) ? 0 : ((px[index] > 1.0) ? 2 : 1);
+				int j = (py[index] < 0.0) ? 0 : ((py[index] > 1.0) ? 2 : 1);
+				int k = (pz[index] < 0.0) ? 0 : ((pz[index] > 1.0) ? 2 : 1);
+				const unsigned target = TransferDirection(i, j, k).getIndex();
+				if(target == center && !absorbing) {
+					return target;
+				}
 
-			// sort out particles
-			std::vector<std::vector<Particle>*> targets(cell.particles.size());
-			//			allscale::api::user::algorithm::pfor(std::size_t(0),cell.particles.size(),[&](std::size_t index){
-			for(std::size_t index = 0; index<cell.particles.size(); ++index) {
+				// remove particles from inside the sphere
+				Vector3<double> diff {
+					cellOrigin.x + px[index] * width.x - universeProperties.objectCenter.x,
+					cellOrigin.y + py[index] * width.y - universeProperties.objectCenter.y,
+					cellOrigin.z + pz[index] * width.z - universeProperties.objectCenter.z
+				};
+				double r2 = allscale::utils::sumOfSquares(diff);
+				if(r2 <= planetRadius2) {
+					return removed;
+				}
+				return target;
+			};
 
-				// get the current particle
-				auto& p = cell.particles[index];
+			// sort out particles: those leaving the cell are swapped to the end of the store
+			std::size_t numRemaining = particles.size();
+			for(std::size_t index = 0; index<numRemaining;) {
 
-				// compute relative position
-				Vector3<double> relPos = p.position - getCenterOfCell(pos, universeProperties);
-				auto halfWidth = universeProperties.cellWidth / 2.0;
+				// get the relative position of the current particle
+				double relPos[3] = { px[index], py[index], pz[index] };
 
-				// if required, "reflect" particle's position and mark that velocity vector should be inverted
+				// if required, "reflect" particle's position by half a cell and mark that velocity vector should be inverted
 				bool invertVelocity = false;
-				auto adjustPosition = [&](const int i) {
-					if((pos[i] == 0) && (relPos[i] < -halfWidth[i])) {
+				for(int d = 0; d < 3; ++d) {
+					if(reflectLow[d] && relPos[d] < 0.0) {
 						invertVelocity = true;
-						return p.position[i] + halfWidth[i];
-					} else if((pos[i] == universeProperties.size[i] - 1) && (relPos[i] > halfWidth[i])) {
+						relPos[d] += 0.5;
+					} else if(reflectHigh[d] && relPos[d] > 1.0) {
 						invertVelocity = true;
-						return p.position[i] - halfWidth[i];
+						relPos[d] -= 0.5;
 					}
-					return p.position[i];
-				};
-
-				p.position[0] = adjustPosition(0);
-				p.position[1] = adjustPosition(1);
-				p.position[2] = adjustPosition(2);
+				}
 
 				if(invertVelocity) {
-					p.velocity *= (-1);
+					px[index] = relPos[0];
+					py[index] = relPos[1];
+					pz[index] = relPos[2];
+					pvx[index] *= -1;
+					pvy[index] *= -1;
+					pvz[index] *= -1;
 				}
 
-				// remove particles from inside the sphere
-				auto diff = p.position - universeProperties.objectCenter;
-				double r2 = allscale::utils::sumOfSquares(diff);
-				if(r2 <= universeProperties.planetRadius * universeProperties.planetRadius) {
-					continue;
+				if(getTarget(index) == center) {
+					// keep particle
+					++index;
+				} else {
+					// move particle to the end, continue with the one swapped in
+					particles.swap(index, --numRemaining);
 				}
+			}
 
-				// recompute potentially new relative position
-				relPos = p.position - getCenterOfCell(pos, universeProperties);
+			// the cells particles are directly handed over to, if any, per direction
+			std::array<Cell*,TransferDirection::NumDirections> local;
+			for(int i = 0; i < 3; ++i) {
+				for(int j = 0; j < 3; ++j) {
+					for(int k = 0; k < 3; ++k) {
+						// neighbors are determined like on import, and particles are never handed over to their own cell
+						auto neighbor = (pos + utils::Coordinate<3>{ i-1, j-1, k-1 } + size) % size;
+						local[TransferDirection(i, j, k).getIndex()] = (neighbor == pos) ? nullptr : getLocalCell(neighbor);
+					}
+				}
+			}
 
-				// send particle to neighboring cell if required
-				if((fabs(relPos.x) > halfWidth.x) || (fabs(relPos.y) > halfWidth.y) || (fabs(relPos.z) > halfWidth.z)) {
+			// count the particles leaving in each direction through the transfer buffer
+			std::array<std::size_t,TransferDirection::NumDirections> counts {};
+			for(std::size_t index = numRemaining; index<particles.size(); ++index) {
+				auto target = getTarget(index);
+				if(target != removed && !local[target]) {
+					counts[target]++;
+				}
+			}
 
-					int i = (relPos.x < -halfWidth.x) ? 0 : ((relPos.x > halfWidth.x) ? 2 : 1);
-					int j = (relPos.y < -halfWidth.y) ? 0 : ((relPos.y > halfWidth.y) ? 2 : 1);
-					int k = (relPos.z < -halfWidth.z) ? 0 : ((relPos.z > halfWidth.z) ? 2 : 1);
+			// re-fill the transfer buffer of this cell, one range per direction
+			auto& out = transfers.getBuffer(pos);
+			out.allocate(counts);
 
-					targets[index] = neighbors[i][j][k];
-				} else {
-					// keep particle
-					targets[index] = &remaining;
-				}
-				//			});
+			std::array<std::size_t,TransferDirection::NumDirections> next;
+			std::size_t offset = 0;
+			for(unsigned d = 0; d < TransferDirection::NumDirections; ++d) {
+				next[d] = offset;
+				offset += counts[d];
 			}
 
 			// actually transfer particles
-			for(std::size_t i = 0; i<cell.particles.size(); ++i) {
-				if(targets[i]) {
-					targets[i]->push_back(cell.particles[i]);
+			auto& emigrants = out.getParticles();
+			for(std::size_t index = numRemaining; index<particles.size(); ++index) {
+				auto target = getTarget(index);
+				if(target == removed) continue;
+
+				// shift the position into the frame of the neighboring cell
+				px[index] -= (px[index] < 0.0) ? -1 : ((px[index] > 1.0) ? 1 : 0);
+				py[index] -= (py[index] < 0.0) ? -1 : ((py[index] > 1.0) ? 1 : 0);
+				pz[index] -= (pz[index] < 0.0) ? -1 : ((pz[index] > 1.0) ? 1 : 0);
+
+				if(local[target]) {
+					local[target]->particles.append(particles, index);
+				} else {
+					emigrants.copy(next[target]++, particles, index);
 				}
 			}
 
+			// drop all particles which left the cell
+			particles.resize(numRemaining);
 		}
 
-		// update content
-		cell.particles.swap(remaining);
+	}
+
+	/**
+	* This function extracts all particles which are no longer in the domain of the
+	* given cell and inserts them into the transfer buffer of this cell, grouped by
+	* the neighbor they are moving to. The buffer is re-filled, retaining its capacity.
+	* Particles remaining in the cell are not moved, yet their order is not preserved.
+	*
+	* @param universeProperties the properties of this universe
+	* @param cell the cell whose particles are moved
+	* @param pos the coordinates of this cell in the grid
+	* @param transfers a grid of buffers to send particles to
+	*/
+	void exportParticles(const UniverseProperties& universeProperties, Cell& cell, const utils::Coordinate<3>& pos, TransferBuffers& transfers) {
+		detail::exportLeavingParticles(universeProperties, cell, pos, transfers, [](const utils::Coordinate<3>&) -> Cell* { return nullptr; });
+	}
+
+	/**
+	* This function extracts all particles which are no longer in the domain of the
+	* given cell like exportParticles, yet appends particles moving to a cell of the
+	* same tile [tileBegin,tileEnd) directly to that cell. Thus, only particles leaving
+	* the tile pass through the transfer buffer of the cell. Cells of the tile receiving
+	* particles have to be moved already within the current time step.
+	*
+	* @param universeProperties the properties of this universe
+	* @param cells the grid of all cells
+	* @param pos the coordinates of the cell whose particles are moved
+	* @param tileBegin the first cell of the tile containing the cell
+	* @param tileEnd the end of the tile containing the cell
+	* @param transfers a grid of buffers to send particles to
+	*/
+	void exportParticles(const UniverseProperties& universeProperties, Cells& cells, const utils::Coordinate<3>& pos, const utils::Coordinate<3>& tileBegin, const utils::Coordinate<3>& tileEnd, TransferBuffers& transfers) {
+		assert_true(tileBegin.dominatedBy(pos) && pos.strictlyDominatedBy(tileEnd)) << "Cell " << pos << " is not part of the tile [" << tileBegin << "," << tileEnd << ")";
+		detail::exportLeavingParticles(universeProperties, cells[pos], pos, transfers, [&](const utils::Coordinate<3>& neighbor) -> Cell* {
+			return (tileBegin.dominatedBy(neighbor) && neighbor.strictlyDominatedBy(tileEnd)) ? &cells[neighbor] : nullptr;
+		});
 	}
 
 	/**
@@ -1168,8 +1490,19 @@ namespace ipic3d {
 	bool verifyCorrectParticlesPositionInCell(const UniverseProperties& universeProperties, Cell& cell, const utils::Coordinate<3>& pos) {
 		int incorrectlyPlacedParticles = 0;
 
-		for(auto& p : cell.particles) {
-			if (!isInside(universeProperties,pos,p)) {
+		// particles are stored relative to the box of their cell
+		const auto& particles = cell.particles;
+		if (particles.getFrameOrigin() != getOriginOfCell(pos, universeProperties) || particles.getFrameWidth() != universeProperties.cellWidth) {
+			std::cerr << "The particles of the cell at the position " << pos << " are not stored relative to the cell\n";
+			return false;
+		}
+
+		// thus all relative coordinates have to be within [0,1]
+		const auto* px = particles.data(ParticleStore::X);
+		const auto* py = particles.data(ParticleStore::Y);
+		const auto* pz = particles.data(ParticleStore::Z);
+		for(std::size_t i = 0; i < particles.size(); ++i) {
+			if (!(0 <= px[i] && px[i] <= 1 && 0 <= py[i] && py[i] <= 1 && 0 <= pz[i] && pz[i] <= 1)) {
 				++incorrectlyPlacedParticles;
 			}
 		}
@@ -1185,14 +1518,15 @@ namespace ipic3d {
 
 	/**
 	* This function imports all particles that are directed towards the specified cell
-	* into the cell from the provided transfer buffers.
+	* from the transfer buffers of its neighbors into the cell. The buffers are not
+	* modified, they are re-filled by the next export of their owning cell.
 	*
 	* @param universeProperties the properties of this universe
 	* @param cell the cell to import particles into
 	* @param pos the coordinates of this cell in the grid
 	* @param transfers a grid of buffers to import particles from
 	*/
-	void importParticles(const UniverseProperties& universeProperties, Cell& cell, const utils::Coordinate<3>& pos, TransferBuffers& transfers) {
+	void importParticles(const UniverseProperties& universeProperties, Cell& cell, const utils::Coordinate<3>& pos, const TransferBuffers& transfers) {
 
 		assert_true(pos.dominatedBy(universeProperties.size)) << "Position " << pos << " is outside universe of size " << universeProperties.size;
 
@@ -1203,13 +1537,14 @@ namespace ipic3d {
 //				for(int k = 0; k<3; k++) {
 //
 //					// skip the center (not relevant)
-////					if (i == 1 && j == 1 && k == 1) continue;
+//					if (i == 1 && j == 1 && k == 1) continue;
 //
-//					// obtain transfer buffer
-//					auto& in = transfers.getBuffer(pos,TransferDirection(i,j,k));
+//					// obtain transfer buffer of neighbor, and the direction pointing towards this cell
+//					auto& in = transfers.getBuffer((pos + utils::Coordinate<3>{ i-1, j-1, k-1 } + size) % size);
+//					TransferDirection dir(2-i, 2-j, 2-k);
 //
 //					// import particles
-//					cell.particles.insert(cell.particles.end(), in.begin(), in.end());
+//					cell.particles.append(in.getParticles(), in.begin(dir), in.end(dir));
 //				}
 //			}
 //		}
@@ -1217,93 +1552,63 @@ namespace ipic3d {
 
 		// NOTE: due to an unimplemented feature in the analysis, this loop needs to be unrolled (work in progress)
 
-		auto import = [&](const auto& in) {
-			if (in.empty()) return;
-			auto& cur = cell.particles;
-			auto oldSize = cur.size();
-			cur.resize(oldSize + in.size());
-			std::memcpy(&cur[oldSize],&in[0],sizeof(Particle) * in.size());
+		auto size = universeProperties.size;
+		auto neighbor = [&](int i, int j, int k) -> const TransferBuffer& {
+			return transfers.getBuffer((pos + utils::Coordinate<3>{ i, j, k } + size) % size);
 		};
 
-        std::array<std::vector<Particle>*, 26> buffers;
-
-        buffers[ 0] = &transfers.getBuffer(pos,TransferDirection(0,0,0));
-        buffers[ 1] = &transfers.getBuffer(pos,TransferDirection(0,0,1));
-        buffers[ 2] = &transfers.getBuffer(pos,TransferDirection(0,0,2));
+		// the buffers of all neighbors, along with the direction pointing towards this cell
+		const std::array<std::pair<const TransferBuffer*,TransferDirection>, 26> sources = {{
 
-        buffers[ 3] = &transfers.getBuffer(pos,TransferDirection(0,1,0));
-        buffers[ 4] = &transfers.getBuffer(pos,TransferDirection(0,1,1));
-        buffers[ 5] = &transfers.getBuffer(pos,TransferDirection(0,1,2));
+			{ &neighbor(-1,-1,-1), TransferDirection(2,2,2) },
+			{ &neighbor(-1,-1, 0), TransferDirection(2,2,1) },
+			{ &neighbor(-1,-1, 1), TransferDirection(2,2,0) },
 
-        buffers[ 6] = &transfers.getBuffer(pos,TransferDirection(0,2,0));
-        buffers[ 7] = &transfers.getBuffer(pos,TransferDirection(0,2,1));
-        buffers[ 8] = &transfers.getBuffer(pos,TransferDirection(0,2,2));
+			{ &neighbor(-1, 0,-1), TransferDirection(2,1,2) },
+			{ &neighbor(-1, 0, 0), TransferDirection(2,1,1) },
+			{ &neighbor(-1, 0, 1), TransferDirection(2,1,0) },
 
-        buffers[ 9] = &transfers.getBuffer(pos,TransferDirection(1,0,0));
-        buffers[10] = &transfers.getBuffer(pos,TransferDirection(1,0,1));
-        buffers[11] = &transfers.getBuffer(pos,TransferDirection(1,0,2));
+			{ &neighbor(-1, 1,-1), TransferDirection(2,0,2) },
+			{ &neighbor(-1, 1, 0), TransferDirection(2,0,1) },
+			{ &neighbor(-1, 1, 1), TransferDirection(2,0,0) },
 
-        buffers[12] = &transfers.getBuffer(pos,TransferDirection(1,1,0));
-		// skipped: import(transfers.getBuffer(pos,TransferDirection(1,1,1)));
-        buffers[13] = &transfers.getBuffer(pos,TransferDirection(1,1,2));
+			{ &neighbor( 0,-1,-1), TransferDirection(1,2,2) },
+			{ &neighbor( 0,-1, 0), TransferDirection(1,2,1) },
+			{ &neighbor( 0,-1, 1), TransferDirection(1,2,0) },
 
-        buffers[14] = &transfers.getBuffer(pos,TransferDirection(1,2,0));
-        buffers[15] = &transfers.getBuffer(pos,TransferDirection(1,2,1));
-        buffers[16] = &transfers.getBuffer(pos,TransferDirection(1,2,2));
-
-        buffers[17] = &transfers.getBuffer(pos,TransferDirection(2,0,0));
-        buffers[18] = &transfers.getBuffer(pos,TransferDirection(2,0,1));
-        buffers[19] = &transfers.getBuffer(pos,TransferDirection(2,0,2));
-
-        buffers[20] = &transfers.getBuffer(pos,TransferDirection(2,1,0));
-        buffers[21] = &transfers.getBuffer(pos,TransferDirection(2,1,1));
-        buffers[22] = &transfers.getBuffer(pos,TransferDirection(2,1,2));
-
-        buffers[23] = &transfers.getBuffer(pos,TransferDirection(2,2,0));
-        buffers[24] = &transfers.getBuffer(pos,TransferDirection(2,2,1));
-        buffers[25] = &transfers.getBuffer(pos,TransferDirection(2,2,2));
-
-        std::size_t newSize = 0;
-        for (auto buffer: buffers)
-            newSize += buffer->size();
-        cell.particles.reserve(cell.particles.size() + newSize);
-
-		// along all 26 directions (center is not relevant)
-		import(*buffers[ 0]);
-		import(*buffers[ 1]);
-		import(*buffers[ 2]);
+			{ &neighbor( 0, 0,-1), TransferDirection(1,1,2) },
+			// skipped: the center
+			{ &neighbor( 0, 0, 1), TransferDirection(1,1,0) },
 
-		import(*buffers[ 3]);
-		import(*buffers[ 4]);
-		import(*buffers[ 5]);
+			{ &neighbor( 0, 1,-1), TransferDirection(1,0,2) },
+			{ &neighbor( 0, 1, 0), TransferDirection(1,0,1) },
+			{ &neighbor( 0, 1, 1), TransferDirection(1,0,0) },
 
-		import(*buffers[ 6]);
-		import(*buffers[ 7]);
-		import(*buffers[ 8]);
+			{ &neighbor( 1,-1,-1), TransferDirection(0,2,2) },
+			{ &neighbor( 1,-1, 0), TransferDirection(0,2,1) },
+			{ &neighbor( 1,-1, 1), TransferDirection(0,2,0) },
 
-		import(*buffers[ 9]);
-		import(*buffers[10]);
-		import(*buffers[11]);
+			{ &neighbor( 1, 0,-1), TransferDirection(0,1,2) },
+			{ &neighbor( 1, 0, 0), TransferDirection(0,1,1) },
+			{ &neighbor( 1, 0, 1), TransferDirection(0,1,0) },
 
-		import(*buffers[12]);
-		// skipped: import(transfers.getBuffer(pos,TransferDirection(1,1,1)));
-		import(*buffers[13]);
+			{ &neighbor( 1, 1,-1), TransferDirection(0,0,2) },
+			{ &neighbor( 1, 1, 0), TransferDirection(0,0,1) },
+			{ &neighbor( 1, 1, 1), TransferDirection(0,0,0) }
 
-		import(*buffers[14]);
-		import(*buffers[15]);
-		import(*buffers[16]);
+		}};
 
-		import(*buffers[17]);
-		import(*buffers[18]);
-		import(*buffers[19]);
-
-		import(*buffers[20]);
-		import(*buffers[21]);
-		import(*buffers[22]);
+		std::size_t newSize = 0;
+		for(const auto& source : sources) {
+			newSize += source.first->size(source.second);
+		}
+		cell.particles.reserve(cell.particles.size() + newSize);
 
-		import(*buffers[23]);
-		import(*buffers[24]);
-		import(*buffers[25]);
+		// along all 26 directions (center is not relevant)
+		for(const auto& source : sources) {
+			const auto& in = *source.first;
+			cell.particles.append(in.getParticles(), in.begin(source.second), in.end(source.second));
+		}
 
 		// verify correct placement of the particles
 		assert_true(verifyCorrectParticlesPositionInCell(universeProperties, cell, pos));
@@ -1313,14 +1618,26 @@ namespace ipic3d {
  	 * This function computes particles total kinetic energy in a cell
  	 */
 	double getParticlesKineticEnergy(const Cell& cell) {
-		auto map = [](const Particle& p, double& res) {
-			res += 0.5 * (p.q / p.qom) * allscale::utils::sumOfSquares(p.velocity);
-		};
-
-		auto reduce = [&](const double& a, const double& b) { return a + b; };
-		auto init = []() { return 0.0; };
+		const auto& particles = cell.particles;
+		const auto* vx = particles.data(ParticleStore::VX);
+		const auto* vy = particles.data(ParticleStore::VY);
+		const auto* vz = particles.data(ParticleStore::VZ);
+		const auto* ids = particles.getSpeciesIds();
+
+		// sum up the squared velocities per species, the mass is applied once per species
+		std::array<double,SpeciesTable::maxSpecies> sums;
+		std::fill(sums.begin(), sums.begin() + particles.getSpecies().size(), 0.0);
+		for(std::size_t i = 0; i < particles.size(); ++i) {
+			sums[ids[i]] += double(vx[i]) * vx[i] + double(vy[i]) * vy[i] + double(vz[i]) * vz[i];
+		}
 
-		return allscale::api::user::algorithm::preduce(cell.particles, map, reduce, init).get();
+		// species without moving particles do not contribute, nor does the mass of unused entries
+		double res = 0.0;
+		for(std::size_t s = 0; s < particles.getSpecies().size(); ++s) {
+			if (sums[s] == 0.0) continue;
+			res += 0.5 * particles.getSpecies()[SpeciesTable::id_type(s)].getMass() * sums[s];
+		}
+		return res;
 	}
 
 	/**
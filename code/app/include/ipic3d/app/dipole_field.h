@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ipic3d/app/utils/simd.h"
+#include "ipic3d/app/vector.h"
+
+namespace ipic3d {
+
+	/**
+	 * The analytic magnetic field of a dipole located at the origin, aligned with the z axis:
+	 *
+	 *     B = factor * (3xz, 3yz, 2z^2 - x^2 - y^2) / r^5,   factor = -B0.z * R^3
+	 *
+	 * where B0 is the external magnetic field and R is the radius of the planet. The constant
+	 * factor is computed once, and r^-5 is obtained from a single inverse square root, avoiding
+	 * any calls to pow() in the evaluation.
+	 */
+	class DipoleField {
+
+		// the constant factor of the field: -B0.z * R^3
+		double factor;
+
+	public:
+
+		/**
+		 * Creates the field of a dipole with the given constant factor (-B0.z * R^3).
+		 */
+		explicit DipoleField(double factor) : factor(factor) {}
+
+		/**
+		 * Creates the field of a planet of the given radius within the given external magnetic field.
+		 */
+		DipoleField(const Vector3<double>& externalMagneticField, double planetRadius)
+			: factor(-externalMagneticField.z * planetRadius * planetRadius * planetRadius) {}
+
+		/**
+		 * Obtains the constant factor of this field.
+		 */
+		double getFactor() const {
+			return factor;
+		}
+
+		/**
+		 * Evaluates this field at the given positions, relative to the dipole, processing all lanes
+		 * of the given value type at once. For V = double, this is the scalar evaluation.
+		 */
+		template<typename V>
+		IPIC3D_ALWAYS_INLINE void evaluate(const V& x, const V& y, const V& z, V& Bx, V& By, V& Bz) const {
+			IPIC3D_NO_FP_CONTRACT
+
+			// r^-5 = (r^-1)^5
+			V r2 = x * x + y * y + z * z;
+			V rinv;
+			utils::simd::inverseSqrt(rinv, r2);
+			V rinv2 = rinv * rinv;
+			V fac1 = factor * (rinv2 * rinv2 * rinv);
+
+			Bx = 3.0 * x * z * fac1;
+			By = 3.0 * y * z * fac1;
+			Bz = (2.0 * (z * z) - (x * x) - (y * y)) * fac1;
+		}
+
+		/**
+		 * Evaluates this field at the given position, relative to the dipole.
+		 */
+		Vector3<double> operator()(const Vector3<double>& position) const {
+			Vector3<double> B;
+			evaluate(position.x, position.y, position.z, B.x, B.y, B.z);
+			return B;
+		}
+
+	};
+
+} // end namespace ipic3d
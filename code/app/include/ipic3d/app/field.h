@@ -1,13 +1,24 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
 #include "allscale/api/user/data/grid.h"
 #include "allscale/api/user/algorithm/pfor.h"
 #include "allscale/api/user/algorithm/preduce.h"
 
+#include "ipic3d/app/dipole_field.h"
+#include "ipic3d/app/halo.h"
 #include "ipic3d/app/vector.h"
 #include "ipic3d/app/init_properties.h"
+#include "ipic3d/app/poisson.h"
 #include "ipic3d/app/universe_properties.h"
+#include "ipic3d/app/utils/krylov.h"
 #include "ipic3d/app/utils/points.h"
+#include "ipic3d/app/utils/simd.h"
+#include "ipic3d/app/utils/space_filling_curve.h"
+#include "ipic3d/app/vector_field.h"
 
 namespace ipic3d {
 
@@ -26,9 +37,9 @@ namespace ipic3d {
 		Vector3<double> J;				// current density
 	};
 
-	//struct DensityCell {
-	//	Vector3<double> rho;			// charge density
-	//};
+	struct ChargeDensityNode {
+		double rho;						// charge density
+	};
 
 
 	using Field = allscale::api::user::data::Grid<FieldNode,3>;	// a 3D grid of field nodes
@@ -37,6 +48,8 @@ namespace ipic3d {
 
 	using CurrentDensity = allscale::api::user::data::Grid<DensityNode,3>;	// a 3D grid of density nodes
 
+	using ChargeDensity = allscale::api::user::data::Grid<ChargeDensityNode,3>;	// a 3D grid of charge density nodes
+
 	// declaration
 	void interpN2C(const utils::Coordinate<3>& pos, const Field& fields, BcField& bcfields);
 
@@ -62,10 +75,7 @@ namespace ipic3d {
 
 		// Compute dipolar field B_ext
 		if (r2 > a*a) {
-			auto fac1 =  -universeProperties.externalMagneticField.z * pow(a, 3) / pow(r2, 2.5);
-			res.Bext.x = 3.0 * diff.x * diff.z * fac1;
-			res.Bext.y = 3.0 * diff.y * diff.z * fac1;
-			res.Bext.z = (2.0 * diff.z * diff.z - diff.x * diff.x - diff.y * diff.y) * fac1;
+			res.Bext = DipoleField(universeProperties.externalMagneticField, a)(diff);
 		} else { // no field inside the planet
 			res.Bext = { 0.0, 0.0, 0.0 };
 		}
@@ -94,7 +104,7 @@ namespace ipic3d {
 
 			case UseCase::Dipole: {
 
-				pfor(start, workingFieldSize, [=,&fields](const utils::Coordinate<3>& cur) {
+				utils::pforInMortonOrder(start, workingFieldSize, [=,&fields](const utils::Coordinate<3>& cur) {
 
 					// Node coordinates
 					// pos-start due to the fact that we have a ghost field
@@ -156,6 +166,22 @@ namespace ipic3d {
 		return currentDensity;
 	}
 
+	ChargeDensity initChargeDensity(const UniverseProperties& universeProperties) {
+
+		using namespace allscale::api::user::algorithm;
+
+		utils::Size<3> densitySize = universeProperties.size + coordinate_type(1);
+
+		// the 3D charge density
+		ChargeDensity chargeDensity(densitySize);
+
+		pfor(densitySize, [&chargeDensity](const utils::Coordinate<3>& cur) {
+			chargeDensity[cur].rho = 0.0;
+		});
+
+		return chargeDensity;
+	}
+
 	/**
  	* calculate curl on nodes, given a vector field defined on central points
  	*/
@@ -264,6 +290,242 @@ namespace ipic3d {
 		bcfields[pos].Bc = .125 * Bn;
 	}
 
+	namespace detail {
+
+		/**
+		* The values of a vector field at the 8 corners of a cell (or the 8 centers around a node) for a run of
+		* W consecutive positions along z, indexed by the corner offsets and the component.
+		*/
+		template<typename V>
+		using CornerValues = V[2][2][2][3];
+
+		/**
+		* The pencils holding the corners of the positions of a pencil of the output, for the corner offsets
+		* along x and y and the component, and the offset of the corners along z.
+		*/
+		struct CornerPencils {
+			const double* pencils[2][2][3];
+			std::int64_t dz[2];
+		};
+
+		/**
+		* The curl on central points of a vector field defined on nodes, see computeCurlE.
+		*/
+		struct CurlOnCenters {
+			Vector3<double> width;
+
+			template<typename V>
+			IPIC3D_ALWAYS_INLINE void operator()(const CornerValues<V>& c, V (&res)[3]) const {
+				// curl - X
+				const V compZDY = .25 * (c[0][1][0][2] - c[0][0][0][2] + c[0][1][1][2] - c[0][0][1][2] + c[1][1][0][2] - c[1][0][0][2] + c[1][1][1][2] - c[1][0][1][2]) / width.y;
+				const V compYDZ = .25 * (c[0][0][1][1] - c[0][0][0][1] + c[1][0][1][1] - c[1][0][0][1] + c[0][1][1][1] - c[0][1][0][1] + c[1][1][1][1] - c[1][1][0][1]) / width.z;
+				res[0] = compZDY - compYDZ;
+
+				// curl - Y
+				const V compXDZ = .25 * (c[0][0][1][0] - c[0][0][0][0] + c[1][0][1][0] - c[1][0][0][0] + c[0][1][1][0] - c[0][1][0][0] + c[1][1][1][0] - c[1][1][0][0]) / width.z;
+				const V compZDX = .25 * (c[1][0][0][2] - c[0][0][0][2] + c[1][0][1][2] - c[0][0][1][2] + c[1][1][0][2] - c[0][1][0][2] + c[1][1][1][2] - c[0][1][1][2]) / width.x;
+				res[1] = compXDZ - compZDX;
+
+				// curl - Z
+				const V compYDX = .25 * (c[1][0][0][1] - c[0][0][0][1] + c[1][0][1][1] - c[0][0][1][1] + c[1][1][0][1] - c[0][1][0][1] + c[1][1][1][1] - c[0][1][1][1]) / width.x;
+				const V compXDY = .25 * (c[0][1][0][0] - c[0][0][0][0] + c[0][1][1][0] - c[0][0][1][0] + c[1][1][0][0] - c[1][0][0][0] + c[1][1][1][0] - c[1][0][1][0]) / width.y;
+				res[2] = compYDX - compXDY;
+			}
+		};
+
+		/**
+		* The curl on nodes of a vector field defined on central points, see computeCurlB.
+		*/
+		struct CurlOnNodes {
+			Vector3<double> width;
+
+			template<typename V>
+			IPIC3D_ALWAYS_INLINE void operator()(const CornerValues<V>& c, V (&res)[3]) const {
+				// curl - X
+				const V compZDY = .25 * (c[0][0][0][2] - c[0][1][0][2] + c[0][0][1][2] - c[0][1][1][2] + c[1][0][0][2] - c[1][1][0][2] + c[1][0][1][2] - c[1][1][1][2]) / width.y;
+				const V compYDZ = .25 * (c[0][0][0][1] - c[0][0][1][1] + c[1][0][0][1] - c[1][0][1][1] + c[0][1][0][1] - c[0][1][1][1] + c[1][1][0][1] - c[1][1][1][1]) / width.z;
+				res[0] = compZDY - compYDZ;
+
+				// curl - Y
+				const V compXDZ = .25 * (c[0][0][0][0] - c[0][0][1][0] + c[1][0][0][0] - c[1][0][1][0] + c[0][1][0][0] - c[0][1][1][0] + c[1][1][0][0] - c[1][1][1][0]) / width.z;
+				const V compZDX = .25 * (c[0][0][0][2] - c[1][0][0][2] + c[0][0][1][2] - c[1][0][1][2] + c[0][1][0][2] - c[1][1][0][2] + c[0][1][1][2] - c[1][1][1][2]) / width.x;
+				res[1] = compXDZ - compZDX;
+
+				// curl - Z
+				const V compYDX = .25 * (c[0][0][0][1] - c[1][0][0][1] + c[0][0][1][1] - c[1][0][1][1] + c[0][1][0][1] - c[1][1][0][1] + c[0][1][1][1] - c[1][1][1][1]) / width.x;
+				const V compXDY = .25 * (c[0][0][0][0] - c[0][1][0][0] + c[0][0][1][0] - c[0][1][1][0] + c[1][0][0][0] - c[1][1][0][0] + c[1][0][1][0] - c[1][1][1][0]) / width.y;
+				res[2] = compYDX - compXDY;
+			}
+		};
+
+		/**
+		* The average over the corners, see interpC2N and interpN2C.
+		*/
+		struct CornerAverage {
+
+			template<typename V>
+			IPIC3D_ALWAYS_INLINE void operator()(const CornerValues<V>& c, V (&res)[3]) const {
+				for(int d = 0; d < 3; ++d) {
+					V sum;
+					utils::simd::broadcast(sum, 0.0);
+					for(int i=0; i<2; i++) {
+						for(int j=0; j<2; j++) {
+							for(int k=0; k<2; k++) {
+								sum += c[i][j][k][d];
+							}
+						}
+					}
+					res[d] = .125 * sum;
+				}
+			}
+		};
+
+		/**
+		* Applies the given corner stencil to the positions [z,z+W) of a pencil of the output.
+		*/
+		template<typename V, typename Stencil>
+		IPIC3D_ALWAYS_INLINE void applyCornerStencilAt(const Stencil& stencil, const CornerPencils& in, double* const (&out)[3], std::int64_t z) {
+			CornerValues<V> c;
+			for(int i=0; i<2; i++) {
+				for(int j=0; j<2; j++) {
+					for(int k=0; k<2; k++) {
+						for(int d = 0; d < 3; ++d) {
+							utils::simd::load(c[i][j][k][d], in.pencils[i][j][d] + z + in.dz[k]);
+						}
+					}
+				}
+			}
+			V res[3];
+			stencil(c, res);
+			for(int d = 0; d < 3; ++d) {
+				utils::simd::store(out[d] + z, res[d]);
+			}
+		}
+
+		/**
+		* Applies the given corner stencil to the positions [begin,end) of a pencil of the output, processing
+		* W positions at a time and the remainder one by one.
+		*/
+		template<typename V, typename Stencil>
+		IPIC3D_ALWAYS_INLINE void applyCornerStencilToPencil(const Stencil& stencil, const CornerPencils& in, double* const (&out)[3], std::int64_t begin, std::int64_t end) {
+			constexpr int W = utils::simd::width<V>::value;
+			std::int64_t z = begin;
+			for(; z + W <= end; z += W) {
+				applyCornerStencilAt<V>(stencil, in, out, z);
+			}
+			for(; z < end; ++z) {
+				applyCornerStencilAt<double>(stencil, in, out, z);
+			}
+		}
+
+		template<typename Stencil>
+		IPIC3D_SCALAR_FUNCTION
+		void applyCornerStencilToPencilScalar(const Stencil& stencil, const CornerPencils& in, double* const (&out)[3], std::int64_t begin, std::int64_t end) {
+			applyCornerStencilToPencil<double>(stencil, in, out, begin, end);
+		}
+
+		#ifdef IPIC3D_X86_SIMD
+
+			template<typename Stencil>
+			IPIC3D_SIMD_FUNCTION("avx2")
+			void applyCornerStencilToPencilAVX2(const Stencil& stencil, const CornerPencils& in, double* const (&out)[3], std::int64_t begin, std::int64_t end) {
+				applyCornerStencilToPencil<utils::simd::double4>(stencil, in, out, begin, end);
+			}
+
+			template<typename Stencil>
+			IPIC3D_SIMD_FUNCTION("avx512f")
+			void applyCornerStencilToPencilAVX512(const Stencil& stencil, const CornerPencils& in, double* const (&out)[3], std::int64_t begin, std::int64_t end) {
+				applyCornerStencilToPencil<utils::simd::double8>(stencil, in, out, begin, end);
+			}
+
+		#endif
+
+		/**
+		* Applies the given corner stencil to all positions of the output field covered by the input field. For
+		* stencils reading the upper corners (offsets 0 and +1), the output is one element smaller than the input
+		* along each dimension and covered entirely. For stencils reading the lower corners (offsets 0 and -1), the
+		* output is one element larger than the input and the values on its boundary are not updated.
+		*/
+		template<typename Stencil>
+		void applyCornerStencil(const Stencil& stencil, const VectorField& in, bool upper, VectorField& out, utils::simd::Level level) {
+			const auto shift = utils::Coordinate<3>(1);
+			assert_true(out.size() == (upper ? in.size() - shift : in.size() + shift)) << "Invalid output size " << out.size() << " for input of size " << in.size();
+
+			const auto begin = upper ? utils::Coordinate<3>(0) : shift;
+			const auto end = upper ? out.size() : in.size();
+			if (!begin.strictlyDominatedBy(end)) return;
+
+			const int sign = upper ? 1 : -1;
+			allscale::api::user::algorithm::pfor(begin, utils::Coordinate<3>{ end.x, end.y, begin.z + 1 }, [&](const utils::Coordinate<3>& pos) {
+				CornerPencils corners;
+				for(int i=0; i<2; i++) {
+					for(int j=0; j<2; j++) {
+						for(int d = 0; d < 3; ++d) {
+							corners.pencils[i][j][d] = in.pencil(d, pos.x + sign * i, pos.y + sign * j);
+						}
+					}
+				}
+				corners.dz[0] = 0;
+				corners.dz[1] = sign;
+
+				double* const res[3] = { out.pencil(0, pos.x, pos.y), out.pencil(1, pos.x, pos.y), out.pencil(2, pos.x, pos.y) };
+				switch(level) {
+					#ifdef IPIC3D_X86_SIMD
+						case utils::simd::Level::AVX512: applyCornerStencilToPencilAVX512(stencil, corners, res, begin.z, end.z); return;
+						case utils::simd::Level::AVX2:   applyCornerStencilToPencilAVX2(stencil, corners, res, begin.z, end.z); return;
+					#endif
+					default: applyCornerStencilToPencilScalar(stencil, corners, res, begin.z, end.z); return;
+				}
+			});
+		}
+
+	}
+
+	/**
+	* Computes the curl on all central points of a vector field defined on nodes, like computeCurlE does for a
+	* single central point. The curl is one element smaller than the field along each dimension. Runs of
+	* consecutive central points along z are processed by vector instructions.
+	*
+	* @param universeProperties the properties of this universe
+	* @param E the vector field defined on nodes
+	* @param curl the resulting curl on central points
+	* @param level the instruction set extensions to be used, must be supported by the CPU
+	*/
+	void computeCurlE(const UniverseProperties& universeProperties, const VectorField& E, VectorField& curl, utils::simd::Level level = utils::simd::getSupportedLevel()) {
+		detail::applyCornerStencil(detail::CurlOnCenters{ universeProperties.cellWidth }, E, true, curl, level);
+	}
+
+	/**
+	* Computes the curl on all nodes surrounded by central points of a vector field defined on central points,
+	* like computeCurlB does for a single node. The curl is one element larger than the field along each
+	* dimension, its boundary is not updated.
+	*
+	* @param universeProperties the properties of this universe
+	* @param Bc the vector field defined on central points
+	* @param curl the resulting curl on nodes
+	* @param level the instruction set extensions to be used, must be supported by the CPU
+	*/
+	void computeCurlB(const UniverseProperties& universeProperties, const VectorField& Bc, VectorField& curl, utils::simd::Level level = utils::simd::getSupportedLevel()) {
+		detail::applyCornerStencil(detail::CurlOnNodes{ universeProperties.cellWidth }, Bc, false, curl, level);
+	}
+
+	/**
+	* Interpolates a vector field defined on central points to all nodes surrounded by central points, like
+	* interpC2N does for a single node. The result is one element larger than the field along each dimension,
+	* its boundary is not updated.
+	*/
+	void interpC2N(const VectorField& Bc, VectorField& B, utils::simd::Level level = utils::simd::getSupportedLevel()) {
+		detail::applyCornerStencil(detail::CornerAverage(), Bc, false, B, level);
+	}
+
+	/**
+	* Interpolates a vector field defined on nodes to all central points, like interpN2C does for a single
+	* central point. The result is one element smaller than the field along each dimension.
+	*/
+	void interpN2C(const VectorField& B, VectorField& Bc, utils::simd::Level level = utils::simd::getSupportedLevel()) {
+		detail::applyCornerStencil(detail::CornerAverage(), B, true, Bc, level);
+	}
+
 	/**
 	* Static filed solver in this case works as a push for simulation at the its beginning.
 	* So that, fields are computed only once and then updated via interpolation
@@ -402,39 +664,376 @@ namespace ipic3d {
 	}
 
 	/**
- 	* Populate and update fields values on boundaries
- 	*/
-	void updateFieldsOnBoundaries(Field& field, BcField& bcfield) {
+	* The default width of the tiles of z-pencils processed by the blocked leapfrog field solver.
+	*/
+	constexpr std::int64_t leapfrogTileWidth = 8;
 
-		auto update = [](const auto& index, const auto& end, auto& field) {
+	namespace detail {
 
-			// update on the x = 0 face
-			field[{ 0, index.x, index.y }] = field[{ end - 1, index.x, index.y }];
-			field[{ end, index.x, index.y }] = field[{ 1, index.x, index.y }];
+		/**
+		* The constants of the leapfrog update, extracted from the universe properties once per sweep.
+		*/
+		struct LeapfrogCoefficients {
+			double dt;						// the time step
+			double c2;						// the square of the speed of light
+			Vector3<double> width;			// the width of the cells
+		};
 
-			// update on the y = 0 face
-			field[{ index.x, 0, index.y }] = field[{ index.x, end - 1, index.y }];
-			field[{ index.x, end, index.y }] = field[{ index.x, 1, index.y }];
+		/**
+		* Applies the leapfrog update of solveFieldLeapfrog to the nodes (x,y,z) with z in [zBegin,zEnd), one
+		* after the other. Values shared by consecutive nodes, i.e. the magnetic field below the current node
+		* and the electric field above it, are carried along the pencil instead of being re-loaded.
+		*/
+		void solveFieldLeapfrogPencil(const LeapfrogCoefficients& coeffs, std::int64_t x, std::int64_t y, std::int64_t zBegin, std::int64_t zEnd, const CurrentDensity& density, Field& field, BcField& bcfield) {
+			const double dt = coeffs.dt;
+			const double c2 = coeffs.c2;
+			const auto& w = coeffs.width;
+
+			// B is only updated on centers not belonging to the ghost layer
+			const auto bcEnd = bcfield.size() - utils::Coordinate<3>(1);
+
+			// the current node and its neighbors, advanced along the pencil
+			utils::Coordinate<3> pos { x, y, zBegin };
+			utils::Coordinate<3> xm { x - 1, y, zBegin };
+			utils::Coordinate<3> ym { x, y - 1, zBegin };
+			utils::Coordinate<3> xp { x + 1, y, zBegin };
+			utils::Coordinate<3> yp { x, y + 1, zBegin };
+			utils::Coordinate<3> zp { x, y, zBegin + 1 };
+			utils::Coordinate<3> j { x - 1, y - 1, zBegin - 1 };	// density is shifted by one, like in solveFieldLeapfrog
+
+			// the (already updated) magnetic field below the current node, and the electric field of the current node
+			Vector3<double> BcZm = bcfield[utils::Coordinate<3>({ x, y, zBegin - 1 })].Bc;
+			Vector3<double> E = field[pos].E;
+
+			for(; pos.z < zEnd; ++pos.z, ++xm.z, ++ym.z, ++xp.z, ++yp.z, ++zp.z, ++j.z) {
+
+				// compute E field
+				const Vector3<double> Bc = bcfield[pos].Bc;
+				const Vector3<double> BcXm = bcfield[xm].Bc;
+				const Vector3<double> BcYm = bcfield[ym].Bc;
+				const Vector3<double>& J = density[j].J;
+
+				E.x = E.x + dt * ( c2 * ( (Bc.z - BcYm.z) / w.y - (Bc.y - BcZm.y) / w.z) - J.x );
+				E.y = E.y + dt * ( c2 * ( (Bc.x - BcZm.x) / w.z - (Bc.z - BcXm.z) / w.x) - J.y );
+				E.z = E.z + dt * ( c2 * ( (Bc.y - BcXm.y) / w.x - (Bc.x - BcYm.x) / w.y) - J.z );
+				field[pos].E = E;
+
+				// the electric field of the next node is not updated yet
+				const Vector3<double> EZp = field[zp].E;
+
+				// compute B field
+				Vector3<double> B = Bc;
+				if (pos < bcEnd) {
+					const Vector3<double>& EXp = field[xp].E;
+					const Vector3<double>& EYp = field[yp].E;
+					B.x = Bc.x - dt * ( (EYp.z - E.z) / w.y - (EZp.y - E.y) / w.z );
+					B.y = Bc.y - dt * ( (EZp.x - E.x) / w.z - (EXp.z - E.z) / w.x );
+					B.z = Bc.z - dt * ( (EXp.y - E.y) / w.x - (EYp.x - E.x) / w.y );
+					bcfield[pos].Bc = B;
+				}
 
-			// update on the z = 0 face
-			field[{ index.x, index.y, 0 }] = field[{ index.x, index.y, end - 1 }];
-			field[{ index.x, index.y, end }] = field[{ index.x, index.y, 1 }];
-		};
+				BcZm = B;
+				E = EZp;
+			}
+		}
+
+	}
+
+	/**
+	* Explicit Field Solver: applies numSteps leapfrog updates of solveFieldLeapfrog to all inner nodes of the
+	* field, i.e. excluding the ghost layer, which is not updated in between. The update of E on a node reads B
+	* on the lower neighbors after their update, while the update of B reads E on the upper neighbors before
+	* their update. The result of a step is thus defined by updating nodes one after the other in lexicographic
+	* order; the result of all steps is reproduced bitwise.
+	*
+	* Nodes are processed in z-pencils, grouped into tiles of tileWidth x tileWidth pencils, such that the
+	* fields of neighboring pencils are still cached when being re-read. Since nodes only depend on their
+	* direct neighbors, the update of a tile only depends on its lower neighbors in x and y; thus, the tiles
+	* of each anti-diagonal are processed in parallel, in a wavefront across the x-y plane.
+	*
+	* All steps are applied to a tile before moving on to the next one (temporal blocking), such that the
+	* fields of a tile are loaded from memory once for all steps. To this end, the tile is shifted towards the
+	* lower neighbors by one pencil per step, such that the nodes of each step only depend on nodes of the
+	* previous step covered by the tile itself or by tiles processed before. Tiles at the lower boundary shrink,
+	* tiles at the upper boundary grow accordingly.
+	*
+	* @param universeProperties the properties of this universe
+	* @param density the current density
+	* @param field the field, whose E component is updated
+	* @param bcfield the magnetic field on the centers of the cells, which is updated
+	* @param numSteps the number of time steps to be applied
+	* @param tileWidth the number of pencils per tile along x and y
+	*/
+	void solveFieldLeapfrogSteps(const UniverseProperties& universeProperties, const CurrentDensity& density, Field& field, BcField& bcfield, unsigned numSteps, std::int64_t tileWidth = leapfrogTileWidth) {
+
+		assert_lt(0, tileWidth);
+
+		switch(universeProperties.useCase) {
+
+			case UseCase::Dipole:
+			{
+				const detail::LeapfrogCoefficients coeffs { universeProperties.dt, universeProperties.speedOfLight * universeProperties.speedOfLight, universeProperties.cellWidth };
+
+				// the inner nodes of the field
+				const auto begin = utils::Coordinate<3>(1);
+				const auto end = field.size() - utils::Coordinate<3>(1);
+				const auto numTiles = utils::getNumBlocks(begin, end, tileWidth);
+				if (numTiles.x <= 0 || numTiles.y <= 0 || !(begin.z < end.z)) return;
+
+				// the lower bound of the given tile along the given dimension in the given step
+				auto getTileBound = [&](int d, std::int64_t tile, std::int64_t step) {
+					if (tile == 0) return begin[d];
+					if (tile == numTiles[d]) return end[d];
+					return std::min(std::max(begin[d] + tile * tileWidth - step, begin[d]), end[d]);
+				};
+
+				// process the anti-diagonals of the grid of tiles one after the other
+				for(std::int64_t diagonal = 0; diagonal < numTiles.x + numTiles.y - 1; ++diagonal) {
+					const std::int64_t first = std::max<std::int64_t>(0, diagonal - numTiles.y + 1);
+					const std::int64_t last = std::min<std::int64_t>(numTiles.x, diagonal + 1);
+					allscale::api::user::algorithm::pfor(first, last, [&,diagonal](std::int64_t tx) {
+						const std::int64_t ty = diagonal - tx;
+						for(std::int64_t step = 0; step < numSteps; ++step) {
+							const std::int64_t xEnd = getTileBound(0, tx + 1, step);
+							const std::int64_t yEnd = getTileBound(1, ty + 1, step);
+							for(std::int64_t x = getTileBound(0, tx, step); x < xEnd; ++x) {
+								for(std::int64_t y = getTileBound(1, ty, step); y < yEnd; ++y) {
+									detail::solveFieldLeapfrogPencil(coeffs, x, y, begin.z, end.z, density, field, bcfield);
+								}
+							}
+						}
+					});
+				}
+
+				break;
+			}
+
+			default:
+				assert_not_implemented() << "The specified use case is not supported yet!";
+		}
+	}
+
+	/**
+	* Explicit Field Solver: applies the leapfrog update of solveFieldLeapfrog to all inner nodes of the field,
+	* i.e. excluding the ghost layer, by a single step of solveFieldLeapfrogSteps.
+	*
+	* @param universeProperties the properties of this universe
+	* @param density the current density
+	* @param field the field, whose E component is updated
+	* @param bcfield the magnetic field on the centers of the cells, which is updated
+	* @param tileWidth the number of pencils per tile along x and y
+	*/
+	void solveFieldLeapfrog(const UniverseProperties& universeProperties, const CurrentDensity& density, Field& field, BcField& bcfield, std::int64_t tileWidth = leapfrogTileWidth) {
+		solveFieldLeapfrogSteps(universeProperties, density, field, bcfield, 1, tileWidth);
+	}
+
+	/**
+	* The operator of the linear system of the implicit Maxwell solver, E + a * curl(curl(E)) with a = (c * theta * dt)^2,
+	* on the nodes of a field. Under periodic boundaries, the nodes on the upper faces of the universe coincide with
+	* the ones on the lower faces, thus the unknowns are the nodes [1,size+1) of a field of size+3 nodes, the remaining
+	* ones forming its ghost layer, which is zero in the result. Then, nodes and centers share the same period, such that
+	* the curl on nodes is the adjoint of the curl on centers and the operator is symmetric positive definite. The curls
+	* are computed by the vectorized kernels, without assembling a matrix.
+	*/
+	class ImplicitMaxwellOperator {
+
+		UniverseProperties universeProperties;
+
+		double factor;
+
+		// the number of distinct nodes along each dimension
+		utils::Size<3> period;
+
+		// intermediate results, re-used between applications
+		mutable VectorField nodes;
+		mutable VectorField centers;
+		mutable VectorField curl;
+
+	public:
+
+		ImplicitMaxwellOperator(const UniverseProperties& universeProperties, const utils::Size<3>& fieldSize)
+			: universeProperties(universeProperties),
+			  factor(std::pow(universeProperties.speedOfLight * universeProperties.theta * universeProperties.dt, 2)),
+			  period(fieldSize - utils::Coordinate<3>(3)),
+			  nodes(fieldSize), centers(fieldSize - utils::Coordinate<3>(1)), curl(fieldSize) {}
+
+		/**
+		* Computes res = A E for the given field E, which is zero on its ghost layer.
+		*/
+		void operator()(const VectorField& E, VectorField& res) const {
+			nodes = E;
+			updatePeriodicHalo(nodes, period);
+			computeCurlE(universeProperties, nodes, centers);
+			updatePeriodicHalo(centers);
+			computeCurlB(universeProperties, centers, curl);
+			clearHalo(curl, period);
+			res = E;
+			addScaled(res, factor, curl);
+		}
+
+	};
+
+	/**
+	* Implicit Maxwell Solver: advances E and B by one time step of the implicit (theta) discretization of Maxwell's equations,
+	*
+	*     E^{n+theta} = E^n + theta * dt * (c^2 * curl(B^{n+theta}) - J)
+	*     B^{n+theta} = B^n - theta * dt * curl(E^{n+theta})
+	*
+	* eliminating B^{n+theta} yields the linear system (I + (c * theta * dt)^2 * curl(curl)) E^{n+theta} = E^n + theta * dt * (c^2 * curl(B^n) - J),
+	* whose operator is symmetric positive definite, such that it is solved by CG, keeping four fields besides the ones of
+	* the operator, up to the relative tolerance GMREStol of the universe properties (named like the field solver tolerance
+	* of iPIC3D), within at most fieldSolverMaxIterations iterations. The diagonal of the operator is constant per
+	* component, such that a Jacobi preconditioner would merely rescale it. Unlike the explicit solvers, the
+	* time step is not limited by the speed of light. However, J is the current deposited by the particles in the previous
+	* step, not one predicted from the response of the particles to E^{n+theta} as in the implicit moment method of iPIC3D,
+	* thus the plasma frequency still limits the time step (omega_p * dt < 2).
+	* Afterwards, B^{n+1} = B^n - dt * curl(E^{n+theta}) and E^{n+1} = (E^{n+theta} - (1 - theta) * E^n) / theta. All
+	* nodes and centers outside the universe are obtained under periodic boundaries (see ImplicitMaxwellOperator), and B
+	* is interpolated to the nodes.
+	*
+	* @param universeProperties the properties of this universe
+	* @param density the current density
+	* @param field the field, whose E and B components are updated
+	* @param bcfield the magnetic field on the centers of the cells, which is updated
+	* @return the statistics of the linear solver
+	*/
+	utils::SolverStatistics solveFieldImplicitMaxwell(const UniverseProperties& universeProperties, const CurrentDensity& density, Field& field, BcField& bcfield) {
+
+		assert_true(0.0 < universeProperties.theta && universeProperties.theta <= 1.0) << "Invalid decentering parameter " << universeProperties.theta;
+		assert_true(bcfield.size() == field.size() - utils::Coordinate<3>(1)) << "Invalid center field size " << bcfield.size() << " for node field size " << field.size();
+		assert_true(density.size() == field.size() - utils::Coordinate<3>(2)) << "Invalid density size " << density.size() << " for node field size " << field.size();
+
+		const double dt = universeProperties.dt;
+		const double theta = universeProperties.theta;
+		const double c2 = universeProperties.speedOfLight * universeProperties.speedOfLight;
+		const utils::Size<3> period = field.size() - utils::Coordinate<3>(3);
+
+		// load the current state
+		VectorField E(field.size());
+		VectorField Bc(bcfield.size());
+		loadVectorField(field, &FieldNode::E, E);
+		loadVectorField(bcfield, &BcFieldCell::Bc, Bc);
+		updatePeriodicHalo(Bc);
+		clearHalo(E, period);
+
+		// the right-hand side: E^n + theta * dt * (c^2 * curl(B^n) - J), where the density is shifted by one, like in solveFieldLeapfrog
+		VectorField rhs(field.size());
+		computeCurlB(universeProperties, Bc, rhs);
+		clearHalo(rhs, period);
+		scale(rhs, c2);
+		allscale::api::user::algorithm::pfor(utils::Coordinate<3>(1), period + utils::Coordinate<3>(1), [&](const utils::Coordinate<3>& pos) {
+			rhs[pos] = Vector3<double>(rhs[pos]) - density[pos - utils::Coordinate<3>(1)].J;
+		});
+		scale(rhs, theta * dt);
+		addScaled(rhs, 1.0, E);
+
+		// solve for E^{n+theta}, starting from E^n
+		const ImplicitMaxwellOperator op(universeProperties, field.size());
+		VectorField Etheta = E;
+		auto stats = utils::solveCG(op, rhs, Etheta, universeProperties.GMREStol, universeProperties.fieldSolverMaxIterations);
+
+		// B^{n+1} = B^n - dt * curl(E^{n+theta}) on the inner centers
+		updatePeriodicHalo(Etheta, period);
+		VectorField curl(bcfield.size());
+		computeCurlE(universeProperties, Etheta, curl);
+		clearHalo(curl);
+		addScaled(Bc, -dt, curl);
+		updatePeriodicHalo(Bc);
+
+		// E^{n+1} = (E^{n+theta} - (1 - theta) * E^n) / theta
+		clearHalo(Etheta, period);
+		addScaled(Etheta, -(1.0 - theta), E);
+		scale(Etheta, 1.0 / theta);
+		updatePeriodicHalo(Etheta, period);
+
+		// interpolate B to the nodes
+		VectorField B(field.size());
+		interpC2N(Bc, B);
+		updatePeriodicHalo(B, period);
+
+		storeVectorField(Etheta, field, &FieldNode::E);
+		storeVectorField(B, field, &FieldNode::B);
+		storeVectorField(Bc, bcfield, &BcFieldCell::Bc);
+
+		return stats;
+	}
+
+	/**
+	* Divergence cleaning: corrects the electric field by the gradient of a potential, such that it satisfies Gauss's law
+	* div(E) = rho for the given charge density (see projectToChargeDensity), up to the tolerance CGtol of the universe
+	* properties. The potential is the solution of the Poisson equation lap(phi) = div(E) - rho, obtained by the given
+	* multigrid solver, and E is replaced by E - grad(phi). Divergences are taken by backward and gradients by forward
+	* differences between nodes, such that their composition is the 7-point Laplacian of the solver; thus, the correction
+	* removes the error of the discrete divergence, except for its mean, which is neutralized by a uniform background
+	* charge in a periodic universe. Like the density, the field is periodic over the N nodes [1,N+1) of each
+	* dimension; the remaining nodes are updated accordingly.
+	*
+	* @param universeProperties the properties of this universe
+	* @param density the charge density
+	* @param field the field, whose E component is corrected
+	* @param solver a Poisson solver of the size of the universe, retaining the potential of the previous correction
+	* @return the statistics of the Poisson solver
+	*/
+	utils::SolverStatistics correctElectricField(const UniverseProperties& universeProperties, const ChargeDensity& density, Field& field, PoissonSolver& solver) {
 
-		// Note: Assumes that the field sizes are equal in each dimension
-		int fieldEnd = (int)field.size().x - 1;
-		int bcfieldEnd = (int)bcfield.size().x - 1;
-		allscale::utils::Vector<int, 2> fullField(fieldEnd);
-		allscale::utils::Vector<int, 2> fullBcField(bcfieldEnd);
-		allscale::utils::Vector<int, 2> start(1);
+		using namespace allscale::api::user::algorithm;
+
+		const auto period = universeProperties.size;
+		assert_true(field.size() == period + utils::Coordinate<3>(3)) << "Invalid field size " << field.size() << " for universe of size " << period;
+		assert_true(density.size() == period + utils::Coordinate<3>(1)) << "Invalid density size " << density.size() << " for universe of size " << period;
+		assert_true(solver.size() == period) << "Invalid solver size " << solver.size() << " for universe of size " << period;
+
+		const auto& w = universeProperties.cellWidth;
+		const Vector3<double> inverseWidth { 1.0 / w.x, 1.0 / w.y, 1.0 / w.z };
+		const utils::Coordinate<3> start = 1;
+		const utils::Coordinate<3> end = period + start;
+
+		// the right-hand side: the backward difference divergence of E, whose lower neighbors wrap around, minus rho
+		auto& rhs = solver.getRightHandSide();
+		pfor(start, end, [&](const utils::Coordinate<3>& pos) {
+			double div = 0.0;
+			for(int d = 0; d < 3; ++d) {
+				auto lower = pos;
+				lower[d] = (pos[d] == 1) ? period[d] : pos[d] - 1;
+				div += (field[pos].E[d] - field[lower].E[d]) * inverseWidth[d];
+			}
+			rhs[pos] = div - density[pos - start].rho;
+		});
+
+		auto stats = solver.solve(universeProperties.CGtol);
+
+		// subtract the forward difference gradient of the potential, whose ghost layer is up to date
+		const auto& phi = solver.getSolution();
+		pfor(start, end, [&](const utils::Coordinate<3>& pos) {
+			Vector3<double> grad;
+			for(int d = 0; d < 3; ++d) {
+				auto upper = pos;
+				upper[d]++;
+				grad[d] = (phi[upper] - phi[pos]) * inverseWidth[d];
+			}
+			field[pos].E -= grad;
+		});
+
+		updatePeriodicHalo(field, period, [](FieldNode& ghost, const FieldNode& source) {
+			ghost.E = source.E;
+		});
+
+		return stats;
+	}
+
+	/**
+ 	* Populate and update fields values on boundaries, including their edges and corners, assuming periodic
+ 	* boundary conditions. Only the dynamic components are updated, the external magnetic field is constant.
+ 	*/
+	void updateFieldsOnBoundaries(Field& field, BcField& bcfield) {
 
-		// TODO: parallel version pending
-		allscale::api::user::algorithm::detail::forEach(start, fullField, [&](const auto& index) {
-			update(index, fieldEnd, field);
+		updatePeriodicHalo(field, [](FieldNode& ghost, const FieldNode& source) {
+			ghost.E = source.E;
+			ghost.B = source.B;
 		});
 
-		allscale::api::user::algorithm::detail::forEach(start, fullBcField, [&](const auto& index) {
-			update(index, bcfieldEnd, bcfield);
+		updatePeriodicHalo(bcfield, [](BcFieldCell& ghost, const BcFieldCell& source) {
+			ghost.Bc = source.Bc;
 		});
 
 	}
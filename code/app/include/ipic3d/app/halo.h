@@ -0,0 +1,109 @@
+#pragma once
+
+#include <vector>
+
+#include "allscale/api/user/algorithm/pfor.h"
+#include "allscale/api/user/data/grid.h"
+#include "allscale/utils/assert.h"
+
+#include "ipic3d/app/transfer_buffer.h"
+#include "ipic3d/app/utils/points.h"
+
+namespace ipic3d {
+
+	/**
+	 * A part of the ghost layer of a grid, adjacent to one of the faces, edges or corners of its
+	 * interior. By default, ghost layers are one element wide, thus the interior of a grid of size s
+	 * covers the range [1,s-1) along each dimension.
+	 */
+	struct HaloRegion {
+
+		// the neighbor of the interior this region is replicating
+		TransferDirection direction;
+
+		// the range of ghost elements covered by this region
+		utils::Coordinate<3> begin;
+		utils::Coordinate<3> end;
+
+		// the offset from each ghost element to the interior element it replicates under periodic boundaries
+		utils::Coordinate<3> offset;
+
+	};
+
+	/**
+	 * Partitions the ghost layer of a grid of the given size into its 6 faces, 12 edges and 8 corners. The
+	 * regions are pairwise disjoint and, under periodic boundaries, replicate interior elements only.
+	 * Hence, all of them may be updated concurrently. A distributed exchange may update the same
+	 * regions from the interiors of the neighboring grids instead.
+	 *
+	 * @param size the size of the grid
+	 * @param period the size of the interior [1,1+period), at least half of the remaining elements
+	 */
+	std::vector<HaloRegion> getHaloRegions(const utils::Size<3>& size, const utils::Size<3>& period) {
+		assert_true(utils::Size<3>(0).strictlyDominatedBy(period) && period.strictlyDominatedBy(size - utils::Size<3>(1))) << "Invalid period " << period << " for grid of size " << size;
+		assert_true((size - utils::Size<3>(1)).dominatedBy(period * 2)) << "Period " << period << " too small for grid of size " << size;
+
+		std::vector<HaloRegion> res;
+		res.reserve(TransferDirection::NumDirections - 1);
+		for(int i = 0; i < 3; ++i) {
+			for(int j = 0; j < 3; ++j) {
+				for(int k = 0; k < 3; ++k) {
+					if (i == TransferDirection::Center && j == TransferDirection::Center && k == TransferDirection::Center) continue;
+
+					const int dir[3] = { i, j, k };
+					utils::Coordinate<3> begin, end, offset;
+					for(int d = 0; d < 3; ++d) {
+						switch(dir[d]) {
+							case TransferDirection::Predecessor:
+								begin[d] = 0; end[d] = 1; offset[d] = period[d]; break;
+							case TransferDirection::Center:
+								begin[d] = 1; end[d] = 1 + period[d]; offset[d] = 0; break;
+							default:
+								begin[d] = 1 + period[d]; end[d] = size[d]; offset[d] = -period[d]; break;
+						}
+					}
+					res.push_back(HaloRegion{ TransferDirection(i, j, k), begin, end, offset });
+				}
+			}
+		}
+		return res;
+	}
+
+	/**
+	 * Partitions the one element wide ghost layer of a grid of the given size, see above.
+	 */
+	std::vector<HaloRegion> getHaloRegions(const utils::Size<3>& size) {
+		assert_true(utils::Size<3>(2).strictlyDominatedBy(size)) << "Grid of size " << size << " has no interior";
+		return getHaloRegions(size, size - utils::Size<3>(2));
+	}
+
+	/**
+	 * Updates the ghost layer of the given grid, surrounding its interior of the given size, by replicating
+	 * the interior under periodic boundaries. The given operation copies the relevant parts of an element,
+	 * such that constant components need not be transferred. Regions are processed in parallel, as are the
+	 * elements of each region.
+	 *
+	 * @param grid the grid whose ghost layer should be updated
+	 * @param period the size of the interior, see getHaloRegions
+	 * @param copy an operation (T& ghost, const T& source) -> void updating a ghost element
+	 */
+	template<typename T, typename Copy>
+	void updatePeriodicHalo(allscale::api::user::data::Grid<T,3>& grid, const utils::Size<3>& period, const Copy& copy) {
+		auto regions = getHaloRegions(grid.size(), period);
+		allscale::api::user::algorithm::pfor(regions, [&](const HaloRegion& region) {
+			allscale::api::user::algorithm::pfor(region.begin, region.end, [&](const utils::Coordinate<3>& pos) {
+				copy(grid[pos], grid[pos + region.offset]);
+			});
+		});
+	}
+
+	/**
+	 * Updates the one element wide ghost layer of the given grid, at least 3 elements wide in each
+	 * dimension, by replicating its interior under periodic boundaries, see above.
+	 */
+	template<typename T, typename Copy>
+	void updatePeriodicHalo(allscale::api::user::data::Grid<T,3>& grid, const Copy& copy) {
+		updatePeriodicHalo(grid, grid.size() - utils::Size<3>(2), copy);
+	}
+
+} // end namespace ipic3d
@@ -80,6 +80,8 @@ namespace ipic3d {
 
 		// Poisson correction flag
 		std::string PoissonCorrection;
+		// the number of cycles between Poisson corrections
+		int PoissonCorrectionCycle = 10;
 
 		// SaveDirName
 		std::string SaveDirName;
@@ -93,6 +95,17 @@ namespace ipic3d {
 		Vector3<double> B1;
 
 
+		// decentering parameter of the implicit Maxwell solver
+		double th = 1.0;
+
+		// stopping criteria of the Poisson and implicit Maxwell solvers (relative residual)
+		double CGtol = 1E-3;
+		double GMREStol = 1E-3;
+
+		// the maximum number of iterations of the implicit Maxwell solver per time step
+		int FieldSolverMaxIterations = 200;
+
+
 		// Output for field
 		int FieldOutputCycle;
 		std::string  FieldOutputTag;
@@ -258,6 +271,11 @@ namespace ipic3d {
 					continue;
 				}
 
+				if ( str.find("PoissonCorrectionCycle") != std::string::npos ) {
+					PoissonCorrectionCycle = std::stoi( split(str).back() );
+					continue;
+				}
+
 				if ( str.find("PoissonCorrection") != std::string::npos ) {
 					PoissonCorrection = split(str).back();
 					continue;
@@ -349,6 +367,25 @@ namespace ipic3d {
 					continue;
 				}
 
+				// the key is a prefix of many others
+				if ( std::regex_search(str, std::regex("^\\s*th\\s*=")) ) {
+					th = std::stod( split(str).back() );
+					continue;
+				}
+
+				if ( str.find("CGtol") != std::string::npos ) {
+					CGtol = std::stod( split(str).back() );
+					continue;
+				}
+				if ( str.find("GMREStol") != std::string::npos ) {
+					GMREStol = std::stod( split(str).back() );
+					continue;
+				}
+				if ( str.find("FieldSolverMaxIterations") != std::string::npos ) {
+					FieldSolverMaxIterations = std::stoi( split(str).back() );
+					continue;
+				}
+
 				if ( str.find("FieldOutputCycle") != std::string::npos ) {
 					FieldOutputCycle = std::stoi( split(str).back() );
 					continue;
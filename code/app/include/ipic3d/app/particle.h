@@ -8,7 +8,7 @@ namespace ipic3d {
 
 	struct Particle {
 
-		Vector3<double> position;			// position (absolute - TODO: relative to cell center)
+		Vector3<double> position;			// position (absolute - cells store it relative to their box)
 
 		Vector3<double> velocity;			// velocity of this particle
 
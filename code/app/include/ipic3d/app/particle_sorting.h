@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ipic3d/app/particle_store.h"
+#include "ipic3d/app/utils/memory_pool.h"
+
+namespace ipic3d {
+
+	/**
+	 * The parameters controlling the sorting of the particles of a cell by the sub-cell they are
+	 * located in. Sorting is a trade-off: it restores the locality of per-particle accesses to
+	 * nodes, yet it moves every particle of the cell. Thus, cells are only sorted if they are
+	 * large enough to not fit into the first level cache anyway and their particles are
+	 * sufficiently out of order. Note that the movers and depositions of this code gather the
+	 * nodes of a cell once per cell, thus none of them benefits from sorting so far.
+	 */
+	struct SubCellSorting {
+
+		// the number of bits of the sub-cell coordinate in each dimension, partitioning cells into 8^levels sub-cells
+		unsigned levels = 2;
+
+		// the minimum number of particles of a cell to be sorted
+		std::size_t minParticles = 256;
+
+		// the fraction of particles out of order tolerated before a cell is sorted
+		double maxDisorder = 0.1;
+
+	};
+
+	/**
+	 * The sub-cell keys of the particles of a store, one per particle.
+	 */
+	using SubCellKeys = utils::PooledVector<std::uint32_t>;
+
+	/**
+	 * Computes the Morton key of the sub-cell containing the given position relative to the
+	 * box of a cell, which is partitioned into 2^levels sub-cells along each dimension. Keys
+	 * of sub-cells which are close in space tend to be close as well. Positions outside the
+	 * box are mapped to the closest sub-cell.
+	 *
+	 * @param x the relative x coordinate, within [0,1]
+	 * @param y the relative y coordinate, within [0,1]
+	 * @param z the relative z coordinate, within [0,1]
+	 * @param levels the number of bits of the sub-cell coordinates, at most 5
+	 * @return the key of the sub-cell, within [0,8^levels)
+	 */
+	std::uint32_t getSubCellKey(double x, double y, double z, unsigned levels) {
+		assert_le(levels, 5u);
+		const double n = double(1u << levels);
+		const double rel[3] = { x, y, z };
+		std::uint32_t coord[3];
+		for(int d = 0; d < 3; ++d) {
+			// the comparisons also map NaN values to the first sub-cell
+			const double scaled = rel[d] * n;
+			coord[d] = (scaled >= 1.0) ? ((scaled < n) ? std::uint32_t(scaled) : (1u << levels) - 1) : 0;
+		}
+
+		// interleave the bits of the coordinates, x being the most significant
+		std::uint32_t key = 0;
+		for(int b = int(levels) - 1; b >= 0; --b) {
+			for(int d = 0; d < 3; ++d) {
+				key = (key << 1) | ((coord[d] >> b) & 1);
+			}
+		}
+		return key;
+	}
+
+	/**
+	 * Computes the sub-cell keys of all particles of the given store.
+	 */
+	template<typename T>
+	void getSubCellKeys(const BasicParticleStore<T>& particles, unsigned levels, SubCellKeys& keys) {
+		using Store = BasicParticleStore<T>;
+		const T* px = particles.data(Store::X);
+		const T* py = particles.data(Store::Y);
+		const T* pz = particles.data(Store::Z);
+		keys.resize(particles.size());
+		for(std::size_t i = 0; i < particles.size(); ++i) {
+			keys[i] = getSubCellKey(px[i], py[i], pz[i], levels);
+		}
+	}
+
+	/**
+	 * Counts the particles of the given store located in a sub-cell preceding the one of their
+	 * predecessor. Sorted stores have no such particles, while particles appended to a sorted
+	 * store, like immigrants, start new runs of keys.
+	 */
+	std::size_t countUnorderedParticles(const SubCellKeys& keys) {
+		std::size_t res = 0;
+		for(std::size_t i = 1; i < keys.size(); ++i) {
+			if (keys[i] < keys[i - 1]) ++res;
+		}
+		return res;
+	}
+
+	/**
+	 * Reorders the particles of the given store in ascending order of the given keys, one per
+	 * particle and each within [0,numKeys). The relative order of the particles sharing a key
+	 * is preserved, thus stores which are already in order are left unchanged.
+	 */
+	template<typename T, typename Keys>
+	void reorderParticlesByKeys(BasicParticleStore<T>& particles, const Keys& keys, std::size_t numKeys) {
+		const std::size_t size = particles.size();
+		assert_eq(size, keys.size());
+
+		// compute the start of each key (counting sort)
+		utils::PooledVector<std::size_t> offsets(numKeys + 1, 0);
+		for(auto k : keys) {
+			assert_lt(std::size_t(k), numKeys);
+			++offsets[k + 1];
+		}
+		for(std::size_t k = 1; k < offsets.size(); ++k) {
+			offsets[k] += offsets[k - 1];
+		}
+
+		// compute the new order of the particles
+		utils::PooledVector<std::size_t> order(size);
+		for(std::size_t i = 0; i < size; ++i) {
+			order[offsets[keys[i]]++] = i;
+		}
+
+		// rearrange the particles in place, gathering one property array at a time through a buffer;
+		// species ids are moved as they are, since the species table remains the same
+		using Store = BasicParticleStore<T>;
+		utils::PooledVector<T> buffer(size);
+		for(int c = 0; c < Store::NUM_COMPONENTS; ++c) {
+			T* values = particles.data(typename Store::Component(c));
+			for(std::size_t i = 0; i < size; ++i) {
+				buffer[i] = values[order[i]];
+			}
+			std::copy(buffer.begin(), buffer.end(), values);
+		}
+		utils::PooledVector<typename Store::species_id_type> ids(size);
+		auto* speciesIds = particles.getSpeciesIds();
+		for(std::size_t i = 0; i < size; ++i) {
+			ids[i] = speciesIds[order[i]];
+		}
+		std::copy(ids.begin(), ids.end(), speciesIds);
+	}
+
+	/**
+	 * Reorders the particles of the given store in ascending order of the given sub-cell keys,
+	 * one per particle. The relative order of the particles within a sub-cell is preserved.
+	 */
+	template<typename T>
+	void sortParticlesByKeys(BasicParticleStore<T>& particles, const SubCellKeys& keys, unsigned levels) {
+		reorderParticlesByKeys(particles, keys, std::size_t(1) << (3 * levels));
+	}
+
+	/**
+	 * Reorders the particles of the given store, whose frame is the box of a cell, by the
+	 * sub-cell they are located in, such that particles sharing (nearby) field nodes are
+	 * adjacent.
+	 *
+	 * @param particles the particles of a cell to be sorted
+	 * @param levels the number of bits of the sub-cell coordinates, at most 5
+	 */
+	template<typename T>
+	void sortParticlesBySubCell(BasicParticleStore<T>& particles, unsigned levels) {
+		SubCellKeys keys;
+		getSubCellKeys(particles, levels, keys);
+		sortParticlesByKeys(particles, keys, levels);
+	}
+
+	/**
+	 * Sorts the particles of the given store by the sub-cell they are located in if it is
+	 * worthwhile according to the given parameters.
+	 *
+	 * @param particles the particles of a cell to be sorted
+	 * @param config the parameters of the sorting
+	 * @return true if the particles got sorted, false otherwise
+	 */
+	template<typename T>
+	bool sortParticlesBySubCellIfDisordered(BasicParticleStore<T>& particles, const SubCellSorting& config) {
+
+		// small cells are cheap to traverse in any order
+		if (particles.size() < config.minParticles) return false;
+
+		SubCellKeys keys;
+		getSubCellKeys(particles, config.levels, keys);
+		if (double(countUnorderedParticles(keys)) <= config.maxDisorder * double(particles.size())) return false;
+
+		sortParticlesByKeys(particles, keys, config.levels);
+		return true;
+	}
+
+} // end namespace ipic3d
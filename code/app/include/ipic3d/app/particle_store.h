@@ -0,0 +1,771 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+#include "allscale/utils/assert.h"
+
+#include "ipic3d/app/particle.h"
+#include "ipic3d/app/utils/memory_pool.h"
+#include "ipic3d/app/vector.h"
+
+namespace ipic3d {
+
+	/**
+	 * The properties shared by all particles of a species.
+	 */
+	struct Species {
+
+		double q;				// charge
+		double qom;				// charge over mass
+
+		double getMass() const {
+			return q / qom;
+		}
+
+		bool operator==(const Species& other) const {
+			return q == other.q && qom == other.qom;
+		}
+
+		bool operator!=(const Species& other) const {
+			return !(*this == other);
+		}
+
+	};
+
+	/**
+	 * A table of the species the particles of a store belong to. Particles only record the
+	 * compact id of their species, indexing this table. Entries are added on demand and are
+	 * never removed, such that ids remain valid for the lifetime of the table.
+	 */
+	class SpeciesTable {
+
+		// the entries of this table, allocated from the memory pool as tables are copied along with their stores
+		utils::PooledVector<Species> entries;
+
+	public:
+
+		using const_iterator = utils::PooledVector<Species>::const_iterator;
+
+		// the type of the ids of species
+		using id_type = std::uint8_t;
+
+		// the maximum number of species within a single table
+		static constexpr std::size_t maxSpecies = 256;
+
+		std::size_t size() const {
+			return entries.size();
+		}
+
+		bool empty() const {
+			return entries.empty();
+		}
+
+		const Species& operator[](id_type id) const {
+			assert_lt(id, entries.size());
+			return entries[id];
+		}
+
+		/**
+		 * Obtains the id of the given species, adding it to this table if not yet present.
+		 */
+		id_type getId(const Species& species) {
+			for(std::size_t i = 0; i < entries.size(); ++i) {
+				if (entries[i] == species) return id_type(i);
+			}
+			assert_lt(entries.size(), std::size_t(maxSpecies)) << "Too many species";
+			entries.push_back(species);
+			return id_type(entries.size() - 1);
+		}
+
+		const_iterator begin() const {
+			return entries.begin();
+		}
+
+		const_iterator end() const {
+			return entries.end();
+		}
+
+		bool operator==(const SpeciesTable& other) const {
+			return entries == other.entries;
+		}
+
+	};
+
+	/**
+	 * A reference to a property of the species of a particle. Assigning a new value moves the
+	 * particle to the species exhibiting the updated properties. To update both properties of a
+	 * particle, the particle is to be assigned as a whole, since each assignment of a single
+	 * property registers the intermediate species in the table.
+	 */
+	struct SpeciesPropertyRef {
+
+		SpeciesTable::id_type& id;
+
+		SpeciesTable& table;
+
+		double Species::* property;
+
+		SpeciesPropertyRef(SpeciesTable::id_type& id, SpeciesTable& table, double Species::* property)
+			: id(id), table(table), property(property) {}
+
+		SpeciesPropertyRef(const SpeciesPropertyRef&) = default;
+
+		SpeciesPropertyRef& operator=(const SpeciesPropertyRef& other) {
+			return *this = double(other);
+		}
+
+		SpeciesPropertyRef& operator=(double v) {
+			Species species = table[id];
+			species.*property = v;
+			id = table.getId(species);
+			return *this;
+		}
+
+		operator double() const {
+			return table[id].*property;
+		}
+
+		friend std::ostream& operator<<(std::ostream& out, const SpeciesPropertyRef& ref) {
+			return out << double(ref);
+		}
+
+	};
+
+	/**
+	 * A reference to a coordinate stored relative to the frame of its cell, i.e. as a fraction
+	 * of the cell width measured from the origin of the cell. Values are read and written
+	 * in absolute coordinates.
+	 */
+	template<typename T>
+	struct ComponentRef {
+
+		T& value;
+
+		double origin;
+		double width;
+
+		ComponentRef(T& value, double origin, double width) : value(value), origin(origin), width(width) {}
+
+		ComponentRef(const ComponentRef&) = default;
+
+		ComponentRef& operator=(const ComponentRef& other) {
+			return *this = double(other);
+		}
+
+		ComponentRef& operator=(double v) {
+			value = T((v - origin) / width);
+			return *this;
+		}
+
+		ComponentRef& operator+=(double v) {
+			return *this = double(*this) + v;
+		}
+
+		ComponentRef& operator-=(double v) {
+			return *this = double(*this) - v;
+		}
+
+		ComponentRef& operator*=(double factor) {
+			return *this = double(*this) * factor;
+		}
+
+		operator double() const {
+			return origin + value * width;
+		}
+
+		friend std::ostream& operator<<(std::ostream& out, const ComponentRef& ref) {
+			return out << double(ref);
+		}
+
+	};
+
+	/**
+	 * A reference to a 3D vector whose components are stored in distinct arrays. The
+	 * component reference type is either a plain reference to the stored value or a
+	 * ComponentRef converting between relative and absolute coordinates. Assignments
+	 * to this proxy are forwarded to the referenced storage locations, values are
+	 * exchanged in double precision.
+	 */
+	template<typename C>
+	struct Vector3Ref {
+
+		C x;
+		C y;
+		C z;
+
+		Vector3Ref(C x, C y, C z) : x(x), y(y), z(z) {}
+
+		Vector3Ref(const Vector3Ref&) = default;
+
+		Vector3Ref& operator=(const Vector3Ref& other) {
+			return *this = Vector3<double>(other);
+		}
+
+		Vector3Ref& operator=(const Vector3<double>& other) {
+			x = other.x;
+			y = other.y;
+			z = other.z;
+			return *this;
+		}
+
+		Vector3Ref& operator+=(const Vector3<double>& other) {
+			x += other.x;
+			y += other.y;
+			z += other.z;
+			return *this;
+		}
+
+		Vector3Ref& operator*=(double factor) {
+			x *= factor;
+			y *= factor;
+			z *= factor;
+			return *this;
+		}
+
+		C operator[](std::size_t i) const {
+			assert_lt(i,3);
+			return (i == 0) ? x : ((i == 1) ? y : z);
+		}
+
+		operator Vector3<double>() const {
+			return { double(x), double(y), double(z) };
+		}
+
+		friend std::ostream& operator<<(std::ostream& out, const Vector3Ref& ref) {
+			return out << Vector3<double>(ref);
+		}
+
+	};
+
+	/**
+	 * A reference to a particle stored within a ParticleStore. It exhibits the same
+	 * member structure as a Particle, yet all accesses are forwarded to the store.
+	 * Positions are exposed in absolute coordinates.
+	 */
+	template<typename T>
+	struct ParticleRef {
+
+		Vector3Ref<ComponentRef<T>> position;
+		Vector3Ref<T&> velocity;
+
+		SpeciesPropertyRef q;
+		SpeciesPropertyRef qom;
+
+		ParticleRef(const Vector3Ref<ComponentRef<T>>& position, const Vector3Ref<T&>& velocity, SpeciesTable::id_type& species, SpeciesTable& table)
+			: position(position), velocity(velocity), q(species, table, &Species::q), qom(species, table, &Species::qom) {}
+
+		ParticleRef(const ParticleRef&) = default;
+
+		ParticleRef& operator=(const ParticleRef& other) {
+			return *this = Particle(other);
+		}
+
+		ParticleRef& operator=(const Particle& p) {
+			position = p.position;
+			velocity = p.velocity;
+			q.id = q.table.getId({ p.q, p.qom });
+			return *this;
+		}
+
+		operator Particle() const {
+			Particle res;
+			res.position = position;
+			res.velocity = velocity;
+			res.q = q;
+			res.qom = qom;
+			return res;
+		}
+
+		friend std::ostream& operator<<(std::ostream& out, const ParticleRef& ref) {
+			return out << Particle(ref);
+		}
+
+	};
+
+	/**
+	 * A container for particles maintaining the individual properties of its
+	 * particles in separate arrays (structure-of-arrays layout). Each array is
+	 * aligned to a cache line and padded to a multiple of the SIMD width, such
+	 * that vectorized kernels may process full registers without peeling.
+	 *
+	 * Elements are accessed through ParticleRef proxies (or Particle copies when
+	 * accessed through a const store), providing a vector-like interface.
+	 *
+	 * The type parameter determines the floating point type the properties are
+	 * stored in. Independently of this type, values are exchanged and processed
+	 * in double precision.
+	 *
+	 * Instead of their charge and charge over mass ratio, particles record the compact id
+	 * of their species, referencing the species table of the store.
+	 *
+	 * Positions are stored relative to the frame of the cell maintaining the store,
+	 * as fractions of the cell width measured from the cell origin, such that a
+	 * particle is located inside its cell if all of its stored coordinates are
+	 * within [0,1]. Element accessors convert to and from absolute coordinates.
+	 */
+	template<typename T>
+	class BasicParticleStore {
+
+		static_assert(std::is_floating_point<T>::value, "Particle properties must be stored as floating point values");
+
+	public:
+
+		// the properties maintained for each particle, each in its own array
+		enum Component { X, Y, Z, VX, VY, VZ, NUM_COMPONENTS };
+
+		// the type of the species ids, stored in an additional array
+		using species_id_type = SpeciesTable::id_type;
+
+		// the alignment of the property arrays (a cache line)
+		static constexpr std::size_t alignment = 64;
+
+		// the number of elements the property arrays are padded to (one AVX-512 register)
+		static constexpr std::size_t simdWidth = alignment / sizeof(T);
+
+		static_assert(alignment <= utils::MemoryPool::alignment, "Property arrays require stronger alignment than provided by the memory pool");
+
+	private:
+
+		// a single block of memory hosting all property arrays, followed by the species ids
+		T* storage;
+
+		// the number of particles in this store
+		std::size_t numParticles;
+
+		// the number of particles the property arrays have room for
+		std::size_t maxParticles;
+
+		// the origin of the frame positions are stored relative to
+		Vector3<double> origin;
+
+		// the extent of the frame positions are stored relative to
+		Vector3<double> width;
+
+		// the species of the particles in this store
+		SpeciesTable species;
+
+		/**
+		 * An iterator over a store, referencing elements by their index.
+		 */
+		template<typename Store, typename Reference>
+		class basic_iterator {
+
+			Store* store;
+			std::ptrdiff_t index;
+
+		public:
+
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type = Particle;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = Reference;
+
+			basic_iterator(Store* store = nullptr, std::ptrdiff_t index = 0) : store(store), index(index) {}
+
+			reference operator*() const { return (*store)[index]; }
+			reference operator[](difference_type n) const { return (*store)[index + n]; }
+
+			basic_iterator& operator++() { ++index; return *this; }
+			basic_iterator& operator--() { --index; return *this; }
+			basic_iterator operator++(int) { auto res = *this; ++index; return res; }
+			basic_iterator operator--(int) { auto res = *this; --index; return res; }
+
+			basic_iterator& operator+=(difference_type n) { index += n; return *this; }
+			basic_iterator& operator-=(difference_type n) { index -= n; return *this; }
+
+			basic_iterator operator+(difference_type n) const { return { store, index + n }; }
+			basic_iterator operator-(difference_type n) const { return { store, index - n }; }
+			friend basic_iterator operator+(difference_type n, const basic_iterator& it) { return it + n; }
+
+			difference_type operator-(const basic_iterator& other) const { return index - other.index; }
+
+			bool operator==(const basic_iterator& other) const { return index == other.index; }
+			bool operator!=(const basic_iterator& other) const { return index != other.index; }
+			bool operator<(const basic_iterator& other) const { return index < other.index; }
+			bool operator<=(const basic_iterator& other) const { return index <= other.index; }
+			bool operator>(const basic_iterator& other) const { return index > other.index; }
+			bool operator>=(const basic_iterator& other) const { return index >= other.index; }
+
+		};
+
+	public:
+
+		using value_type = Particle;
+		using storage_type = T;
+		using size_type = std::size_t;
+		using reference = ParticleRef<T>;
+		using const_reference = Particle;
+		using iterator = basic_iterator<BasicParticleStore,ParticleRef<T>>;
+		using const_iterator = basic_iterator<const BasicParticleStore,Particle>;
+
+		BasicParticleStore() : storage(nullptr), numParticles(0), maxParticles(0), origin(0.0), width(1.0) {}
+
+		BasicParticleStore(const BasicParticleStore& other) : BasicParticleStore() {
+			origin = other.origin;
+			width = other.width;
+			species = other.species;
+			append(other);
+		}
+
+		BasicParticleStore(BasicParticleStore&& other)
+			: storage(other.storage), numParticles(other.numParticles), maxParticles(other.maxParticles), origin(other.origin), width(other.width), species(std::move(other.species)) {
+			other.storage = nullptr;
+			other.numParticles = 0;
+			other.maxParticles = 0;
+		}
+
+		~BasicParticleStore() {
+			utils::MemoryPool::getLocalPool().release(storage, getStorageSize(maxParticles));
+		}
+
+		BasicParticleStore& operator=(const BasicParticleStore& other) {
+			if (this == &other) return *this;
+			clear();
+			origin = other.origin;
+			width = other.width;
+			species = other.species;
+			append(other);
+			return *this;
+		}
+
+		BasicParticleStore& operator=(BasicParticleStore&& other) {
+			swap(other);
+			return *this;
+		}
+
+		// -- size and capacity --
+
+		std::size_t size() const {
+			return numParticles;
+		}
+
+		bool empty() const {
+			return numParticles == 0;
+		}
+
+		std::size_t capacity() const {
+			return maxParticles;
+		}
+
+		/**
+		 * Makes sure that this store has room for at least the given number of particles.
+		 */
+		void reserve(std::size_t newCapacity) {
+			if (newCapacity <= maxParticles) return;
+
+			// round up to a multiple of the SIMD width
+			newCapacity = ((newCapacity + simdWidth - 1) / simdWidth) * simdWidth;
+
+			// allocate a new block of memory from the pool of this thread, with zero-initialized padding
+			auto& pool = utils::MemoryPool::getLocalPool();
+			std::size_t bytes = getStorageSize(newCapacity);
+			T* newStorage = static_cast<T*>(pool.allocate(bytes));
+			std::memset(newStorage, 0, bytes);
+
+			// move existing particles
+			if (storage) {
+				for(int c = 0; c < NUM_COMPONENTS; ++c) {
+					std::memcpy(newStorage + c * newCapacity, storage + c * maxParticles, numParticles * sizeof(T));
+				}
+				std::memcpy(newStorage + NUM_COMPONENTS * newCapacity, getSpeciesIds(), numParticles * sizeof(species_id_type));
+				pool.release(storage, getStorageSize(maxParticles));
+			}
+
+			storage = newStorage;
+			maxParticles = newCapacity;
+		}
+
+		/**
+		 * Resizes this store to the given number of particles. New particles are zero-initialized and
+		 * reference the species of id 0, which is not registered; they have to be overwritten (e.g.
+		 * by copy) before their species is accessed.
+		 */
+		void resize(std::size_t newSize) {
+			grow(newSize);
+			if (newSize <= numParticles) {
+				numParticles = newSize;
+				return;
+			}
+			for(std::size_t i = numParticles; i < newSize; ++i) {
+				for(int c = 0; c < NUM_COMPONENTS; ++c) {
+					data(Component(c))[i] = T(0);
+				}
+			}
+			std::memset(getSpeciesIds() + numParticles, 0, (newSize - numParticles) * sizeof(species_id_type));
+			numParticles = newSize;
+		}
+
+		/**
+		 * Removes all particles while retaining the allocated capacity.
+		 */
+		void clear() {
+			numParticles = 0;
+		}
+
+		/**
+		 * Exchanges the particles at the given positions within this store.
+		 */
+		void swap(std::size_t i, std::size_t j) {
+			assert_lt(i, numParticles);
+			assert_lt(j, numParticles);
+			for(int c = 0; c < NUM_COMPONENTS; ++c) {
+				auto* values = data(Component(c));
+				std::swap(values[i], values[j]);
+			}
+			std::swap(getSpeciesIds()[i], getSpeciesIds()[j]);
+		}
+
+		void swap(BasicParticleStore& other) {
+			std::swap(storage, other.storage);
+			std::swap(numParticles, other.numParticles);
+			std::swap(maxParticles, other.maxParticles);
+			std::swap(origin, other.origin);
+			std::swap(width, other.width);
+			std::swap(species, other.species);
+		}
+
+		// -- frame of reference --
+
+		/**
+		 * Obtains the origin of the frame positions are stored relative to.
+		 */
+		const Vector3<double>& getFrameOrigin() const {
+			return origin;
+		}
+
+		/**
+		 * Obtains the extent of the frame positions are stored relative to.
+		 */
+		const Vector3<double>& getFrameWidth() const {
+			return width;
+		}
+
+		/**
+		 * Updates the frame positions are stored relative to, typically the box of the cell
+		 * maintaining this store. Particles already stored retain their absolute position.
+		 */
+		void setFrame(const Vector3<double>& newOrigin, const Vector3<double>& newWidth) {
+			assert_true(newWidth.x > 0 && newWidth.y > 0 && newWidth.z > 0) << "Invalid frame width: " << newWidth;
+			if (newOrigin == origin && newWidth == width) return;
+			for(int d = 0; d < 3; ++d) {
+				T* pos = data(Component(X + d));
+				for(std::size_t i = 0; i < numParticles; ++i) {
+					pos[i] = T(((origin[d] + pos[i] * width[d]) - newOrigin[d]) / newWidth[d]);
+				}
+			}
+			origin = newOrigin;
+			width = newWidth;
+		}
+
+		// -- raw property access --
+
+		/**
+		 * Obtains the array storing the given property of all particles in this store.
+		 */
+		T* data(Component c) {
+			return storage + c * maxParticles;
+		}
+
+		const T* data(Component c) const {
+			return storage + c * maxParticles;
+		}
+
+		/**
+		 * Obtains the array storing the species ids of all particles in this store.
+		 */
+		species_id_type* getSpeciesIds() {
+			return reinterpret_cast<species_id_type*>(storage + NUM_COMPONENTS * maxParticles);
+		}
+
+		const species_id_type* getSpeciesIds() const {
+			return reinterpret_cast<const species_id_type*>(storage + NUM_COMPONENTS * maxParticles);
+		}
+
+		/**
+		 * Obtains the table of species referenced by the species ids of this store.
+		 */
+		const SpeciesTable& getSpecies() const {
+			return species;
+		}
+
+		/**
+		 * Obtains the id of the given species within this store, registering it if necessary.
+		 */
+		species_id_type getSpeciesId(const Species& s) {
+			return species.getId(s);
+		}
+
+		// -- element access --
+
+		ParticleRef<T> operator[](std::size_t i) {
+			assert_lt(i, numParticles);
+			return {
+				{
+					{ data(X)[i], origin.x, width.x },
+					{ data(Y)[i], origin.y, width.y },
+					{ data(Z)[i], origin.z, width.z }
+				},
+				{ data(VX)[i], data(VY)[i], data(VZ)[i] },
+				getSpeciesIds()[i], species
+			};
+		}
+
+		Particle operator[](std::size_t i) const {
+			assert_lt(i, numParticles);
+			Particle res;
+			res.position = {
+				origin.x + data(X)[i] * width.x,
+				origin.y + data(Y)[i] * width.y,
+				origin.z + data(Z)[i] * width.z
+			};
+			res.velocity = { data(VX)[i], data(VY)[i], data(VZ)[i] };
+			const auto& s = species[getSpeciesIds()[i]];
+			res.q = s.q;
+			res.qom = s.qom;
+			return res;
+		}
+
+		ParticleRef<T> front() { return (*this)[0]; }
+		Particle front() const { return (*this)[0]; }
+
+		ParticleRef<T> back() { return (*this)[numParticles - 1]; }
+		Particle back() const { return (*this)[numParticles - 1]; }
+
+		iterator begin() { return { this, 0 }; }
+		iterator end() { return { this, std::ptrdiff_t(numParticles) }; }
+
+		const_iterator begin() const { return { this, 0 }; }
+		const_iterator end() const { return { this, std::ptrdiff_t(numParticles) }; }
+
+		const_iterator cbegin() const { return begin(); }
+		const_iterator cend() const { return end(); }
+
+		// -- modifiers --
+
+		void push_back(const Particle& p) {
+			grow(numParticles + 1);
+			(*this)[numParticles++] = p;
+		}
+
+		void pop_back() {
+			assert_false(empty());
+			--numParticles;
+		}
+
+		/**
+		 * Appends the particles of the range [begin,end) of the given store to this store.
+		 * Positions are copied in their relative form, thus particles keep their position
+		 * relative to the frame of their cell; the frame of the given store is ignored.
+		 */
+		void append(const BasicParticleStore& other, std::size_t begin, std::size_t end) {
+			assert_le(begin, end);
+			assert_le(end, other.size());
+			assert_ne(this, &other);
+			if (begin == end) return;
+			auto count = end - begin;
+			grow(numParticles + count);
+			for(int c = 0; c < NUM_COMPONENTS; ++c) {
+				std::memcpy(data(Component(c)) + numParticles, other.data(Component(c)) + begin, count * sizeof(T));
+			}
+
+			// translate the species ids of the other store into ids of this store, only registering
+			// the species of the appended particles, such that unused entries are not propagated
+			auto* ids = getSpeciesIds() + numParticles;
+			const auto* otherIds = other.getSpeciesIds() + begin;
+			bool used[SpeciesTable::maxSpecies] = {};
+			for(std::size_t i = 0; i < count; ++i) {
+				used[otherIds[i]] = true;
+			}
+			species_id_type mapping[SpeciesTable::maxSpecies];
+			bool identity = true;
+			for(std::size_t s = 0; s < other.species.size(); ++s) {
+				if (!used[s]) continue;
+				mapping[s] = species.getId(other.species[species_id_type(s)]);
+				identity = identity && mapping[s] == s;
+			}
+			if (identity) {
+				std::memcpy(ids, otherIds, count * sizeof(species_id_type));
+			} else {
+				for(std::size_t i = 0; i < count; ++i) {
+					ids[i] = mapping[otherIds[i]];
+				}
+			}
+
+			numParticles += count;
+		}
+
+		/**
+		 * Appends the particle at the given index of the given store to this store.
+		 */
+		void append(const BasicParticleStore& other, std::size_t index) {
+			assert_lt(index, other.size());
+			grow(numParticles + 1);
+			++numParticles;
+			copy(numParticles - 1, other, index);
+		}
+
+		/**
+		 * Overwrites the particle at the given position of this store by the particle at the given
+		 * index of the given store. Like for append, the position is copied in its relative form.
+		 */
+		void copy(std::size_t pos, const BasicParticleStore& other, std::size_t index) {
+			assert_lt(pos, numParticles);
+			assert_lt(index, other.size());
+			for(int c = 0; c < NUM_COMPONENTS; ++c) {
+				data(Component(c))[pos] = other.data(Component(c))[index];
+			}
+			getSpeciesIds()[pos] = species.getId(other.species[other.getSpeciesIds()[index]]);
+		}
+
+		/**
+		 * Appends all particles of the given store to this store.
+		 */
+		void append(const BasicParticleStore& other) {
+			append(other, 0, other.size());
+		}
+
+	private:
+
+		/**
+		 * Obtains the size of the block of memory hosting the arrays of a store of the given capacity.
+		 */
+		static std::size_t getStorageSize(std::size_t capacity) {
+			return NUM_COMPONENTS * capacity * sizeof(T) + capacity * sizeof(species_id_type);
+		}
+
+		/**
+		 * Increases the capacity of this store geometrically to fit at least the given number of particles.
+		 */
+		void grow(std::size_t minCapacity) {
+			if (minCapacity <= maxParticles) return;
+			reserve(std::max(minCapacity, 2 * maxParticles));
+		}
+
+	};
+
+	template<typename T>
+	constexpr std::size_t BasicParticleStore<T>::alignment;
+
+	template<typename T>
+	constexpr std::size_t BasicParticleStore<T>::simdWidth;
+
+	// the floating point type particle properties are stored in, selected by the USE_SINGLE_PRECISION_PARTICLES build option
+	#ifdef IPIC3D_SINGLE_PRECISION_PARTICLES
+		using particle_storage_type = float;
+	#else
+		using particle_storage_type = double;
+	#endif
+
+	// the particle container utilized by cells and transfer buffers
+	using ParticleStore = BasicParticleStore<particle_storage_type>;
+
+} // end namespace ipic3d
@@ -0,0 +1,318 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "allscale/api/user/algorithm/pfor.h"
+#include "allscale/api/user/algorithm/preduce.h"
+#include "allscale/api/user/data/grid.h"
+#include "allscale/utils/assert.h"
+
+#include "ipic3d/app/halo.h"
+#include "ipic3d/app/utils/krylov.h"
+#include "ipic3d/app/utils/points.h"
+#include "ipic3d/app/vector.h"
+
+namespace ipic3d {
+
+	// the number of relaxation sweeps before and after the coarse grid correction of each level
+	constexpr unsigned multigridSmoothingSweeps = 2;
+
+	// the number of relaxation sweeps solving the coarsest level, of at most 2 elements along each dimension
+	constexpr unsigned multigridCoarsestSweeps = 8;
+
+	// the maximum number of V-cycles of a single solve
+	constexpr unsigned poissonSolverMaxCycles = 50;
+
+	using ScalarField = allscale::api::user::data::Grid<double,3>;	// a 3D grid of scalars
+
+	/**
+	 * A geometric multigrid solver for the Poisson equation lap(phi) = f on a periodic, uniform grid, where
+	 * lap is the 7-point Laplacian. The unknowns of a grid of size n are stored in the interior [1,n+1) of
+	 * scalar fields with a one element wide ghost layer, see getHaloRegions.
+	 *
+	 * The solver runs V-cycles: each level is smoothed by red-black Gauss-Seidel sweeps, whose colours are
+	 * updated in parallel, and the residual is corrected on the next coarser level. Each dimension of more than
+	 * 2 elements is coarsened from n to ceil(n/2) elements spanning the same period, such that sizes which are
+	 * not powers of two are coarsened as well. The correction is interpolated (multi)linearly between the
+	 * elements of the two levels, and the residual is restricted by the transposed interpolation; for even
+	 * sizes, these are the usual trilinear interpolation and full weighting. The coarsest level, of at most 2
+	 * elements along each dimension, is solved by relaxation. Thus, the cost of a cycle is linear in the number
+	 * of unknowns, and the number of cycles is independent of the grid size.
+	 *
+	 * Under periodic boundaries, the solution is defined up to a constant, and the equation is only solvable
+	 * for right-hand sides of zero mean. Thus, the mean of the right-hand side is removed and the solution
+	 * is normalized to zero mean.
+	 */
+	class PoissonSolver {
+
+		struct Level {
+
+			// the number of unknowns along each dimension
+			utils::Size<3> size;
+
+			// the inverse squared widths of the cells along each dimension
+			Vector3<double> weights;
+
+			ScalarField solution;
+			ScalarField rhs;
+			ScalarField residual;
+
+			Level(const utils::Size<3>& size, const Vector3<double>& cellWidth)
+				: size(size),
+				  weights({ 1.0 / (cellWidth.x * cellWidth.x), 1.0 / (cellWidth.y * cellWidth.y), 1.0 / (cellWidth.z * cellWidth.z) }),
+				  solution(size + utils::Size<3>(2)), rhs(size + utils::Size<3>(2)), residual(size + utils::Size<3>(2)) {
+				allscale::api::user::algorithm::pfor(solution.size(), [&](const utils::Coordinate<3>& pos) {
+					solution[pos] = 0.0;
+					rhs[pos] = 0.0;
+					residual[pos] = 0.0;
+				});
+			}
+
+			utils::Coordinate<3> begin() const {
+				return utils::Coordinate<3>(1);
+			}
+
+			utils::Coordinate<3> end() const {
+				return size + utils::Coordinate<3>(1);
+			}
+
+		};
+
+		// the transfer between the elements of a dimension of a fine level and those of the next coarser level
+		struct Transfer {
+
+			// for each fine element, the coarse element preceding or coinciding with it
+			std::vector<std::int64_t> lower;
+
+			// for each fine element, the interpolation weight of the coarse element succeeding lower
+			std::vector<double> upperWeight;
+
+			// for each coarse element, the restricted fine elements and their weights
+			std::vector<std::vector<std::pair<std::int64_t,double>>> sources;
+
+			Transfer(std::int64_t fine, std::int64_t coarse) : lower(fine), upperWeight(fine), sources(coarse) {
+				for(std::int64_t i = 0; i < fine; ++i) {
+					// the position of fine element i in units of coarse elements
+					lower[i] = i * coarse / fine;
+					upperWeight[i] = double(i * coarse % fine) / fine;
+
+					// the restriction is the transposed interpolation, scaled to preserve constants
+					const double scale = double(coarse) / fine;
+					sources[lower[i]].emplace_back(i, (1.0 - upperWeight[i]) * scale);
+					if (upperWeight[i] > 0.0) sources[(lower[i] + 1) % coarse].emplace_back(i, upperWeight[i] * scale);
+				}
+			}
+
+		};
+
+		// the levels, from the finest to the coarsest
+		std::vector<Level> levels;
+
+		// the transfers of the dimensions between level l and level l+1
+		std::vector<std::array<Transfer,3>> transfers;
+
+	public:
+
+		/**
+		 * Creates a solver for a periodic grid of the given size and cell widths.
+		 */
+		PoissonSolver(const utils::Size<3>& size, const Vector3<double>& cellWidth) {
+			assert_true(utils::Size<3>(0).strictlyDominatedBy(size)) << "Invalid size " << size;
+			levels.emplace_back(size, cellWidth);
+			auto coarsen = [](std::int64_t n) { return n > 2 ? (n + 1) / 2 : n; };
+			auto width = cellWidth;
+			for(auto cur = size; cur != utils::Size<3>{ coarsen(cur.x), coarsen(cur.y), coarsen(cur.z) }; ) {
+				const utils::Size<3> next = { coarsen(cur.x), coarsen(cur.y), coarsen(cur.z) };
+				for(int d = 0; d < 3; ++d) {
+					width[d] *= double(cur[d]) / next[d];
+				}
+				transfers.push_back({{ Transfer(cur.x, next.x), Transfer(cur.y, next.y), Transfer(cur.z, next.z) }});
+				levels.emplace_back(next, width);
+				cur = next;
+			}
+		}
+
+		const utils::Size<3>& size() const {
+			return levels.front().size;
+		}
+
+		unsigned getNumLevels() const {
+			return unsigned(levels.size());
+		}
+
+		/**
+		 * Obtains the right-hand side f, to be filled in the interior before solving.
+		 */
+		ScalarField& getRightHandSide() {
+			return levels.front().rhs;
+		}
+
+		/**
+		 * Obtains the solution phi, including its up-to-date ghost layer after solving. The solution of the
+		 * previous solve is the initial guess of the next one.
+		 */
+		const ScalarField& getSolution() const {
+			return levels.front().solution;
+		}
+
+		/**
+		 * Solves the Poisson equation for the current right-hand side, starting from the current solution.
+		 *
+		 * @param tolerance the requested norm of the residual relative to the norm of the right-hand side
+		 * @param maxCycles the maximum number of V-cycles
+		 * @return the statistics of the solver, counting V-cycles as iterations
+		 */
+		utils::SolverStatistics solve(double tolerance, unsigned maxCycles = poissonSolverMaxCycles) {
+			auto& finest = levels.front();
+
+			// only the part of zero mean is solvable
+			const double mean = sum(finest, [&](const utils::Coordinate<3>& pos) { return finest.rhs[pos]; }) / getNumElements(finest);
+			allscale::api::user::algorithm::pfor(finest.begin(), finest.end(), [&](const utils::Coordinate<3>& pos) {
+				finest.rhs[pos] -= mean;
+			});
+			const double rhsNorm = std::sqrt(sum(finest, [&](const utils::Coordinate<3>& pos) { return finest.rhs[pos] * finest.rhs[pos]; }));
+
+			utils::SolverStatistics res { 0, 0.0, true };
+			if (rhsNorm == 0.0) {
+				allscale::api::user::algorithm::pfor(finest.solution.size(), [&](const utils::Coordinate<3>& pos) {
+					finest.solution[pos] = 0.0;
+				});
+				return res;
+			}
+
+			while(true) {
+				computeResidual(finest);
+				res.residual = std::sqrt(sum(finest, [&](const utils::Coordinate<3>& pos) { return finest.residual[pos] * finest.residual[pos]; })) / rhsNorm;
+				res.converged = res.residual <= tolerance;
+				if (res.converged || res.iterations >= maxCycles) break;
+				cycle(0);
+				res.iterations++;
+			}
+
+			// normalize the solution
+			const double offset = sum(finest, [&](const utils::Coordinate<3>& pos) { return finest.solution[pos]; }) / getNumElements(finest);
+			allscale::api::user::algorithm::pfor(finest.begin(), finest.end(), [&](const utils::Coordinate<3>& pos) {
+				finest.solution[pos] -= offset;
+			});
+			updateHalo(finest.solution);
+			return res;
+		}
+
+	private:
+
+		static double getNumElements(const Level& level) {
+			return double(level.size.x) * double(level.size.y) * double(level.size.z);
+		}
+
+		template<typename Op>
+		static double sum(const Level& level, const Op& op) {
+			auto map = [&](const utils::Coordinate<3>& pos, double& res) { res += op(pos); };
+			auto reduce = [](const double& a, const double& b) { return a + b; };
+			auto init = []() { return 0.0; };
+			return allscale::api::user::algorithm::preduce(level.begin(), level.end(), map, reduce, init).get();
+		}
+
+		static void updateHalo(ScalarField& field) {
+			updatePeriodicHalo(field, [](double& ghost, const double& source) { ghost = source; });
+		}
+
+		// the sum of the weighted neighbors of the given element
+		static double getNeighborSum(const Level& level, const ScalarField& field, const utils::Coordinate<3>& pos) {
+			double res = 0.0;
+			for(int d = 0; d < 3; ++d) {
+				auto lower = pos;
+				auto upper = pos;
+				lower[d]--;
+				upper[d]++;
+				res += level.weights[d] * (field[lower] + field[upper]);
+			}
+			return res;
+		}
+
+		static void smooth(Level& level, unsigned sweeps) {
+			const double diagonal = 2.0 * (level.weights.x + level.weights.y + level.weights.z);
+			for(unsigned i = 0; i < sweeps; ++i) {
+				for(int colour = 0; colour < 2; ++colour) {
+					updateHalo(level.solution);
+					// elements of the same colour are not adjacent, except across the boundaries of grids of odd
+					// sizes, where they obtain each other's previous values from the ghost layer
+					allscale::api::user::algorithm::pfor(level.begin(), utils::Coordinate<3>{ level.size.x + 1, level.size.y + 1, 2 }, [&](const utils::Coordinate<3>& pencil) {
+						auto pos = pencil;
+						for(pos.z = 1 + (pencil.x + pencil.y + 1 + colour) % 2; pos.z <= level.size.z; pos.z += 2) {
+							level.solution[pos] = (getNeighborSum(level, level.solution, pos) - level.rhs[pos]) / diagonal;
+						}
+					});
+				}
+			}
+		}
+
+		static void computeResidual(Level& level) {
+			const double diagonal = 2.0 * (level.weights.x + level.weights.y + level.weights.z);
+			updateHalo(level.solution);
+			allscale::api::user::algorithm::pfor(level.begin(), level.end(), [&](const utils::Coordinate<3>& pos) {
+				level.residual[pos] = level.rhs[pos] - (getNeighborSum(level, level.solution, pos) - diagonal * level.solution[pos]);
+			});
+		}
+
+		// restricts the residual of the fine level to the right-hand side of the coarse one
+		static void restrictResidual(const std::array<Transfer,3>& transfer, const Level& fine, Level& coarse) {
+			allscale::api::user::algorithm::pfor(coarse.begin(), coarse.end(), [&](const utils::Coordinate<3>& pos) {
+				double res = 0.0;
+				for(const auto& x : transfer[0].sources[pos.x - 1]) {
+					for(const auto& y : transfer[1].sources[pos.y - 1]) {
+						for(const auto& z : transfer[2].sources[pos.z - 1]) {
+							res += x.second * y.second * z.second * fine.residual[{ x.first + 1, y.first + 1, z.first + 1 }];
+						}
+					}
+				}
+				coarse.rhs[pos] = res;
+				coarse.solution[pos] = 0.0;
+			});
+		}
+
+		// interpolates the coarse solution, added to the fine one
+		static void prolongateCorrection(const std::array<Transfer,3>& transfer, Level& coarse, Level& fine) {
+			updateHalo(coarse.solution);
+			allscale::api::user::algorithm::pfor(fine.begin(), fine.end(), [&](const utils::Coordinate<3>& pos) {
+				utils::Coordinate<3> base;
+				Vector3<double> upper;
+				for(int d = 0; d < 3; ++d) {
+					base[d] = transfer[d].lower[pos[d] - 1] + 1;
+					upper[d] = transfer[d].upperWeight[pos[d] - 1];
+				}
+				double res = 0.0;
+				for(int i = 0; i <= (upper.x > 0.0); ++i) {
+					for(int j = 0; j <= (upper.y > 0.0); ++j) {
+						for(int k = 0; k <= (upper.z > 0.0); ++k) {
+							const double weight = (i ? upper.x : 1.0 - upper.x) * (j ? upper.y : 1.0 - upper.y) * (k ? upper.z : 1.0 - upper.z);
+							res += weight * coarse.solution[base + utils::Coordinate<3>{ i, j, k }];
+						}
+					}
+				}
+				fine.solution[pos] += res;
+			});
+		}
+
+		void cycle(std::size_t l) {
+			auto& level = levels[l];
+
+			// the coarsest level is small enough to be solved by relaxation
+			if (l + 1 == levels.size()) {
+				smooth(level, multigridCoarsestSweeps);
+				return;
+			}
+
+			smooth(level, multigridSmoothingSweeps);
+			computeResidual(level);
+			restrictResidual(transfers[l], level, levels[l + 1]);
+			cycle(l + 1);
+			prolongateCorrection(transfers[l], levels[l + 1], level);
+			smooth(level, multigridSmoothingSweeps);
+		}
+
+	};
+
+} // end namespace ipic3d
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <array>
 #include <chrono>
+#include <iostream>
+#include <memory>
+#include <type_traits>
 
 #include "allscale/api/core/io.h"
 
@@ -8,6 +12,7 @@
 #include "ipic3d/app/field.h"
 #include "ipic3d/app/transfer_buffer.h"
 #include "ipic3d/app/universe.h"
+#include "ipic3d/app/utils/space_filling_curve.h"
 
 namespace ipic3d {
 
@@ -31,7 +36,13 @@ namespace ipic3d {
 
 		struct leapfrog_field_solver;
 
+		struct implicit_maxwell_field_solver;
+
 		struct default_particle_mover;
+
+		struct sub_cycle_grouping_particle_mover;
+
+		struct field_interpolating_particle_mover;
 	}
 
 	struct DurationMeasurement {
@@ -124,6 +135,32 @@ namespace ipic3d {
 
 	}
 
+	namespace detail {
+
+		/**
+		* Determines whether the given field solver updates all fields at once, instead of a single node.
+		*/
+		template<typename FieldSolver>
+		struct is_global_field_solver : public std::false_type {};
+
+		template<>
+		struct is_global_field_solver<implicit_maxwell_field_solver> : public std::true_type {};
+
+		// node-wise field solvers are not applied in the time loop yet
+		template<typename ParticleToFieldProjector, typename FieldSolver, typename Settle>
+		void solveFields(const ParticleToFieldProjector&, const FieldSolver&, Universe&, const Settle&, std::false_type) {}
+
+		// global field solvers have to wait for all particles to be moved and located in their cells, as those are reading
+		// the field and are projected to the current density driving the solver
+		template<typename ParticleToFieldProjector, typename FieldSolver, typename Settle>
+		void solveFields(const ParticleToFieldProjector& particleToFieldProjector, const FieldSolver& fieldSolver, Universe& universe, const Settle& settleParticles, std::true_type) {
+			settleParticles();
+			particleToFieldProjector(universe.properties, universe.cells, universe.currentDensity);
+			fieldSolver(universe.properties, universe.currentDensity, universe.field, universe.bcfield);
+		}
+
+	}
+
 	template<
 		typename ParticleToFieldProjector,
 		typename FieldSolver,
@@ -132,8 +169,8 @@ namespace ipic3d {
 	DurationMeasurement simulateSteps(std::uint64_t numSteps, Universe& universe) {
 
 		// instantiate operators
-		//auto particleToFieldProjector = ParticleToFieldProjector();
-		//auto fieldSolver = FieldSolver();
+		auto particleToFieldProjector = ParticleToFieldProjector();
+		auto fieldSolver = FieldSolver();
 		auto particleMover = ParticleMover();
 
 		// -- setup simulation --
@@ -149,12 +186,26 @@ namespace ipic3d {
 
 		// -- auxiliary structures for communication --
 
-		// create a buffer for particle transfers
-		TransferBuffers particleTransfers(size);
+		// create two sets of buffers for particle transfers, alternating between time steps:
+		// particles exported in step i are imported by their destination cell in step i+1
+		std::array<TransferBuffers,2> particleTransfers {{ TransferBuffers(size), TransferBuffers(size) }};
+
+		// the cell-wise import of particles from the given buffers
+		auto importFrom = [&universe](const TransferBuffers& buffers) {
+			return [&universe,&buffers](const utils::Coordinate<3>& pos) {
+				importParticles(universe.properties, universe.cells[pos], pos, buffers);
+			};
+		};
+
+		// the charge density and the Poisson solver of the periodic divergence cleaning of the electric field, if enabled
+		const std::uint64_t poissonCorrectionCycle = universe.properties.poissonCorrectionCycle;
+		std::unique_ptr<ChargeDensity> chargeDensity;
+		std::unique_ptr<PoissonSolver> poissonSolver;
+		if (poissonCorrectionCycle > 0) {
+			chargeDensity = std::make_unique<ChargeDensity>(initChargeDensity(universe.properties));
+			poissonSolver = std::make_unique<PoissonSolver>(size, universe.properties.cellWidth);
+		}
 
-		// create a grid of buffers for density projection from particles to grid nodes
-		Grid<DensityNode> densityContributions(size * 2);
-		
 #ifdef ENABLE_DEBUG_OUTPUT
 		// create the output file
 		auto& manager = allscale::api::core::FileIOManager::getInstance();
@@ -177,27 +228,67 @@ namespace ipic3d {
 		auto start = std::chrono::high_resolution_clock::now();
 		auto endFirst = start;
 
+		// cells are processed in cubic tiles, forming the unit of scheduling and particle migration; the cells of
+		// each tile are visited along a Morton curve, such that cells processed consecutively touch neighboring
+		// transfer buffers and field nodes
+		const std::int64_t tileWidth = universe.properties.tileWidth;
+		assert_lt(0, tileWidth);
+		auto forAllTiles = [zero,size,tileWidth](const auto& body, const auto& ... dependency) {
+			return utils::pforBlocks(zero, size, tileWidth, body, dependency...);
+		};
+		auto forAllCells = [](const auto& op) {
+			return [op](const utils::Coordinate<3>& low, const utils::Coordinate<3>& high) {
+				utils::forEachInMortonOrder(low, high, op);
+			};
+		};
+
+		// the loop of the most recent time step; tiles only synchronize with their neighbors in between steps
+		auto migration = forAllTiles([](const utils::Coordinate<3>&, const utils::Coordinate<3>&) {});
+
+		// a neighborhood_sync does not connect the tiles on opposite faces of the periodic universe, although cells import
+		// from the buffers of their periodic neighbors; with at most two tiles along each dimension those tiles are direct
+		// neighbors anyway, otherwise consecutive loops have to be separated by a global barrier
+		const auto numTiles = utils::getNumBlocks(zero, size, tileWidth);
+		const bool wrapNeedsBarrier = numTiles.x > 2 || numTiles.y > 2 || numTiles.z > 2;
+		auto afterMigration = [&](const auto& body) {
+			using allscale::api::user::algorithm::neighborhood_sync;
+			if (wrapNeedsBarrier) {
+				migration.wait();
+				return forAllTiles(body);
+			}
+			return forAllTiles(body, neighborhood_sync(migration));
+		};
+
+		// completes the migration of the steps preceding the given one, such that all particles are located in their cells
+		std::uint64_t numMigratedSteps = 0;
+		auto completeMigration = [&](std::uint64_t step) {
+			if (numMigratedSteps < step) {
+				auto& consumed = particleTransfers[(step - 1) % 2];
+				migration = afterMigration(forAllCells(importFrom(consumed)));
+
+				// importing does not consume buffers, thus they need to be cleared to not be imported again by the next step
+				migration = afterMigration(forAllCells([&consumed](const utils::Coordinate<3>& pos) {
+					consumed.getBuffer(pos).clear();
+				}));
+				numMigratedSteps = step;
+			}
+			migration.wait();
+		};
+
 		// run time loop for the simulation
 		for(std::uint64_t i = 0; i < numSteps; ++i) {
 
 			using namespace allscale::api::user::algorithm;
 
 #ifdef ENABLE_DEBUG_OUTPUT
+			// complete the migration of the previous step, such that all particles are located in their cells
+			completeMigration(i);
+
 			// write output to a file: total energy, momentum, E and B total energy
 			writeOutputData(i, numSteps, universe, outtxt, fileName);
 #endif
-			// STEP 1a: collect particle density contributions and store in buffers
-			//pfor(zero, size, [&](const utils::Coordinate<3>& pos) {
-			//	// TODO: this can be improved by adding rho
-			//	// 	J is defined on nodes
-			//	particleToFieldProjector(universe.properties, universe.cells[pos], pos, densityContributions);
-			//});
-
-			//// STEP 1b: aggregate densities in buffers to density nodes
-			//pfor(zero, universe.currentDensity.size(), [&](const utils::Coordinate<3>& pos) {
-			//	// 	J is defined on nodes
-			//	aggregateDensityContributions(universe.properties, densityContributions, pos, universe.currentDensity[pos]);
-			//});
+			// STEP 1: project particles to the current density defined on the nodes
+			// NOTE: this is part of solving the fields, as only global field solvers are applied so far
 
 			// STEP 2: solve field equations
 			// update boundaries
@@ -207,29 +298,52 @@ namespace ipic3d {
 			//pfor(fieldStart, fieldEnd, [&](const utils::Coordinate<3>& pos){
 			//	fieldSolver(universe.properties, pos, universe.currentDensity, universe.field, universe.bcfield);
 			//});
+			detail::solveFields(particleToFieldProjector, fieldSolver, universe, [&]() { completeMigration(i); }, detail::is_global_field_solver<FieldSolver>());
+
+			// every poissonCorrectionCycle steps, clean the divergence of the electric field; the charge density requires all
+			// particles to be located in their cells, and the particles of the previous step are reading the field
+			if (poissonCorrectionCycle > 0 && i % poissonCorrectionCycle == 0) {
+				completeMigration(i);
+				projectToChargeDensity(universe.properties, universe.cells, *chargeDensity);
+				correctElectricField(universe.properties, *chargeDensity, universe.field, *poissonSolver);
+			}
 
 			// -- implicit global sync - TODO: can this be eliminated? --
 
-			// STEP 3: project forces to particles and move particles
-			pfor(zero, size, [particleMover,&universe,&particleTransfers](const utils::Coordinate<3>& pos){
-				particleMover(universe.properties, universe.cells[pos], pos, universe.field, particleTransfers);
-			});
-
-			// -- implicit global sync - TODO: can this be eliminated? --
+			// STEP 3: import particles sent to each cell in the previous step, project forces to particles and move particles
+			// NOTE: a tile may start this step as soon as its neighbors (including periodic ones, see above) completed the previous
+			//       one, as they only exchange particles through the double-buffered transfers; any step updating the field has to
+			//       re-introduce a global sync
+			auto import = importFrom(particleTransfers[(i + 1) % 2]);	// the buffers filled in the previous step
+			auto& outgoing = particleTransfers[i % 2];
+			migration = afterMigration([import,particleMover,&universe,&outgoing](const utils::Coordinate<3>& low, const utils::Coordinate<3>& high){
+
+				// move the particles of all cells of the tile ...
+				utils::forEachInMortonOrder(low, high, [&](const utils::Coordinate<3>& pos) {
+					import(pos);
+					particleMover(universe.properties, universe.cells[pos], pos, universe.field);
+				});
+
+				// ... before handing particles moving within the tile directly over, such that no particle is moved twice
+				utils::forEachInMortonOrder(low, high, [&](const utils::Coordinate<3>& pos) {
+					exportParticles(universe.properties, universe.cells, pos, low, high, outgoing);
+				});
 
-			// STEP 4: import particles into destination cells
-			pfor(zero, size, [&](const utils::Coordinate<3>& pos){
-				importParticles(universe.properties, universe.cells[pos], pos, particleTransfers);
 			});
 
-			// -- implicit global sync - TODO: can this be eliminated? --
-			
 			if(i == 0) {
+				migration.wait();
 				endFirst = std::chrono::high_resolution_clock::now();
 			}
 
 		}
 
+		// STEP 4: import particles exported in the last step into their destination cells
+		if (numSteps > 0) {
+			migration = afterMigration(forAllCells(importFrom(particleTransfers[(numSteps - 1) % 2])));
+		}
+		migration.wait();
+
 		auto endAll = std::chrono::high_resolution_clock::now();
 		auto durationFirst = endFirst - start;
 		auto durationRemaining = endAll - endFirst;
@@ -244,8 +358,8 @@ namespace ipic3d {
 	namespace detail {
 
 		struct default_particle_to_field_projector {
-			void operator()(const UniverseProperties& universeProperties, const Cells& cells, const utils::Coordinate<3>& pos, CurrentDensity& densityContributions) const {
-				projectToDensityField(universeProperties, cells, pos, densityContributions);
+			void operator()(const UniverseProperties& universeProperties, const Cells& cells, CurrentDensity& density) const {
+				projectToDensityField(universeProperties, cells, density);
 			}
 		};
 
@@ -267,10 +381,30 @@ namespace ipic3d {
 			}
 		};
 
+		struct implicit_maxwell_field_solver {
+			void operator()(const UniverseProperties& universeProperties, const CurrentDensity& density, Field& field, BcField& bcfield) const {
+				auto stats = solveFieldImplicitMaxwell(universeProperties, density, field, bcfield);
+				if (!stats.converged) {
+					std::cerr << "Warning: the implicit Maxwell solver did not converge within " << stats.iterations << " iterations, the relative residual is " << stats.residual << std::endl;
+				}
+			}
+		};
+
 		struct default_particle_mover {
-			void operator()(const UniverseProperties& properties, Cell& cell, const utils::Coordinate<3>& pos, const Field& field, TransferBuffers& particleTransfers) const {
+			void operator()(const UniverseProperties& properties, Cell& cell, const utils::Coordinate<3>& pos, const Field& field) const {
 				moveParticles(properties, cell, pos, field);
-				exportParticles(properties, cell, pos, particleTransfers);
+			}
+		};
+
+		struct sub_cycle_grouping_particle_mover {
+			void operator()(const UniverseProperties& properties, Cell& cell, const utils::Coordinate<3>& pos, const Field& field) const {
+				moveParticlesGroupedBySubCycles(properties, cell, pos, field);
+			}
+		};
+
+		struct field_interpolating_particle_mover {
+			void operator()(const UniverseProperties& properties, Cell& cell, const utils::Coordinate<3>& pos, const Field& field) const {
+				moveParticlesInField(properties, cell, pos, field);
 			}
 		};
 	}
@@ -1,11 +1,11 @@
 #pragma once
 
 #include <array>
-#include <vector>
+#include <cstddef>
 
 #include "allscale/api/user/data/grid.h"
 
-#include "ipic3d/app/particle.h"
+#include "ipic3d/app/particle_store.h"
 
 namespace ipic3d {
 
@@ -14,7 +14,7 @@ namespace ipic3d {
 	 */
 	class TransferDirection {
 
-		friend class TransferBuffers;
+		friend class TransferBuffer;
 
 		unsigned direction;
 
@@ -28,34 +28,129 @@ namespace ipic3d {
 		constexpr static Direction Center      = 1;
 		constexpr static Direction Successor   = 2;
 
+		// the number of distinct directions (including the center)
+		constexpr static unsigned NumDirections = 27;
+
 		/**
 		 * Creates a new transfer direction instance pointing in the specified direction.
 		 */
-		TransferDirection(Direction x, Direction y, Direction z) : direction((x << 4) | (y << 2) | z) {
+		TransferDirection(Direction x, Direction y, Direction z) : direction((x * 3 + y) * 3 + z) {
 			assert_true(0 <= x && x < 3) << x;
 			assert_true(0 <= y && y < 3) << y;
 			assert_true(0 <= z && z < 3) << z;
 		}
 
+		/**
+		 * Obtains a linear index of this direction within [0,NumDirections).
+		 */
+		unsigned getIndex() const {
+			return direction;
+		}
+
 	};
 
 	/**
-	 * A class organizing particle-transfer buffers within a simulation.
-	 * Internally, this class maintains particle transfer lists connecting
-	 * each pair of adjacent cells in a given 3D grid. In each direction,
-	 * two distinct buffers are maintained.
+	 * A buffer for the particles leaving a single cell within a time step. All particles
+	 * are maintained in a single store, grouped by the direction they are leaving in, with
+	 * a table of offsets marking the range of each direction. The capacity of the store is
+	 * retained when the buffer is re-filled, such that buffers do not cause any memory
+	 * management once they reached their working size.
 	 */
-	class TransferBuffers {
+	class TransferBuffer {
+
+		// the particles leaving the cell, grouped by direction
+		ParticleStore particles;
+
+		// the start of the range of each direction, the last entry marking the end of all ranges
+		std::array<std::size_t,TransferDirection::NumDirections + 1> offsets;
+
+	public:
+
+		TransferBuffer() {
+			offsets.fill(0);
+		}
+
+		/**
+		 * Removes all particles while retaining the allocated capacity.
+		 */
+		void clear() {
+			particles.clear();
+			offsets.fill(0);
+		}
+
+		/**
+		 * Re-fills this buffer with the given number of particles per direction. The particles
+		 * of each direction are zero-initialized and have to be set within the range of their
+		 * direction afterwards.
+		 */
+		void allocate(const std::array<std::size_t,TransferDirection::NumDirections>& counts) {
+			offsets[0] = 0;
+			for(unsigned i = 0; i < TransferDirection::NumDirections; ++i) {
+				offsets[i + 1] = offsets[i] + counts[i];
+			}
+			particles.clear();
+			particles.resize(offsets[TransferDirection::NumDirections]);
+		}
+
+		/**
+		 * Determines whether this buffer contains no particles.
+		 */
+		bool empty() const {
+			return particles.empty();
+		}
+
+		/**
+		 * Obtains the total number of particles in this buffer.
+		 */
+		std::size_t size() const {
+			return particles.size();
+		}
 
-		using particle_list = std::vector<Particle>;
+		/**
+		 * Obtains the number of particles leaving in the given direction.
+		 */
+		std::size_t size(const TransferDirection& dir) const {
+			return end(dir) - begin(dir);
+		}
 
-		using buffer_grid = allscale::api::user::data::Grid<particle_list,3>;
+		/**
+		 * Obtains the index of the first particle leaving in the given direction.
+		 */
+		std::size_t begin(const TransferDirection& dir) const {
+			return offsets[dir.direction];
+		}
 
-		using d1 = std::array<buffer_grid,3>;
-		using d2 = std::array<d1,3>;
-		using d3 = std::array<d2,3>;
+		/**
+		 * Obtains the index following the last particle leaving in the given direction.
+		 */
+		std::size_t end(const TransferDirection& dir) const {
+			return offsets[dir.direction + 1];
+		}
 
-		d3 buffers;
+		/**
+		 * Obtains the store of all particles in this buffer.
+		 */
+		ParticleStore& getParticles() {
+			return particles;
+		}
+
+		const ParticleStore& getParticles() const {
+			return particles;
+		}
+
+	};
+
+	/**
+	 * A class organizing particle-transfer buffers within a simulation.
+	 * Internally, this class maintains one buffer per cell of a given
+	 * 3D grid, collecting the particles leaving the cell towards any of
+	 * its neighbors.
+	 */
+	class TransferBuffers {
+
+		using buffer_grid = allscale::api::user::data::Grid<TransferBuffer,3>;
+
+		buffer_grid buffers;
 
 	public:
 
@@ -65,31 +160,17 @@ namespace ipic3d {
 		/**
 		 * Creates a transfere buffer for a grid of the given size.
 		 */
-		TransferBuffers(const grid_size_t& size)
-			: buffers(d3{ {
-				d2{{
-					d1{{buffer_grid(size),buffer_grid(size),buffer_grid(size)}},
-					d1{{buffer_grid(size),buffer_grid(size),buffer_grid(size)}},
-					d1{{buffer_grid(size),buffer_grid(size),buffer_grid(size)}}
-				}},
-				d2{{
-					d1{{buffer_grid(size),buffer_grid(size),buffer_grid(size)}},
-					d1{{buffer_grid(size),buffer_grid(size),buffer_grid(size)}},
-					d1{{buffer_grid(size),buffer_grid(size),buffer_grid(size)}}
-				}},
-				d2{{
-					d1{{buffer_grid(size),buffer_grid(size),buffer_grid(size)}},
-					d1{{buffer_grid(size),buffer_grid(size),buffer_grid(size)}},
-					d1{{buffer_grid(size),buffer_grid(size),buffer_grid(size)}}
-				}}
-			}}) {}
+		TransferBuffers(const grid_size_t& size) : buffers(size) {}
 
 		/**
-		 * Obtains a transfer buffer for a source cell at the given position targeting
-		 * the given direction.
+		 * Obtains the transfer buffer of the particles leaving the cell at the given position.
 		 */
-		particle_list& getBuffer(const grid_pos_t& src, const TransferDirection& dir) {
-			return buffers[(dir.direction >> 4) & 0x3][(dir.direction >> 2) & 0x3][dir.direction & 0x3][src];
+		TransferBuffer& getBuffer(const grid_pos_t& src) {
+			return buffers[src];
+		}
+
+		const TransferBuffer& getBuffer(const grid_pos_t& src) const {
+			return buffers[src];
 		}
 
 	};
@@ -33,7 +33,7 @@ namespace ipic3d {
 		* @param properties the properties of the universe to be created
 		*/
 	    Universe(const UniverseProperties& properties = UniverseProperties())
-	        : properties(properties), cells(Cells(properties.size)), field(Field(properties.size + coordinate_type(3))), bcfield(BcField(properties.size + coordinate_type(2))), currentDensity(CurrentDensity(properties.size + coordinate_type(1))) // two for the two extra boundary cells and one as fields are defined on nodes of the cells
+	        : properties(properties), cells(createCells(properties)), field(Field(properties.size + coordinate_type(3))), bcfield(BcField(properties.size + coordinate_type(2))), currentDensity(CurrentDensity(properties.size + coordinate_type(1))) // two for the two extra boundary cells and one as fields are defined on nodes of the cells
 		{ 
 			auto dims = properties.size;
 			assert_true(dims.x > 0 || dims.y > 0 || dims.z > 0) << "Expected positive non-zero dimensions, but got " << dims;
@@ -5,6 +5,7 @@
 #include "ipic3d/app/vector.h"
 #include "ipic3d/app/parameters.h"
 
+#include <algorithm>
 #include <map>
 
 namespace ipic3d {
@@ -73,6 +74,17 @@ namespace ipic3d {
 		int FieldOutputCycle;
 		int ParticleOutputCycle;
 		std::string outputFileBaseName;
+		// the width of the cubic tiles of cells forming the unit of scheduling and particle migration
+		unsigned tileWidth = 4;
+		// the decentering parameter of the implicit Maxwell solver, in (0,1]
+		double theta = 1.0;
+		// the stopping criteria of the Poisson and implicit Maxwell solvers (relative residual), named like in iPIC3D
+		double CGtol = 1e-3;
+		double GMREStol = 1e-3;
+		// the maximum number of iterations per time step of the implicit Maxwell solver
+		unsigned fieldSolverMaxIterations = 200;
+		// the number of time steps between divergence cleanings of the electric field, 0 to disable them
+		unsigned poissonCorrectionCycle = 0;
 
 	    UniverseProperties(const UseCase& useCase = UseCase::Dipole, const coordinate_type& size = {1, 1, 1}, const Vector3<double>& cellWidth = {1.0, 1.0, 1.0},
 			const double dt = 1.0, const double speedOfLight = 1.0, const double planetRadius = 0.0, const Vector3<double>& objectCenter = { 0.0, 0.0, 0.0 }, const Vector3<double>& origin = { 0.0, 0.0, 0.0 }, const Vector3<double>& externalMagneticField = { 0,0,0 }, const int FieldOutputCycle = 100, const int ParticleOutputCycle = 100)
@@ -96,7 +108,12 @@ namespace ipic3d {
 			planetRadius( params.planetRadius ),
 			objectCenter({ params.objectCenter.x, params.objectCenter.y, params.objectCenter.z }),
 			FieldOutputCycle ( params.FieldOutputCycle ),
-			ParticleOutputCycle ( params.ParticlesOutputCycle ) 
+			ParticleOutputCycle ( params.ParticlesOutputCycle ),
+			theta ( params.th ),
+			CGtol ( params.CGtol ),
+			GMREStol ( params.GMREStol ),
+			fieldSolverMaxIterations ( unsigned(std::max(params.FieldSolverMaxIterations, 1)) ),
+			poissonCorrectionCycle ( (params.PoissonCorrection == "yes") ? unsigned(std::max(params.PoissonCorrectionCycle, 0)) : 0u )
 		{
 			origin.x = params.objectCenter.x - params.ncells.x * params.dspace.x / 2.0;
 			origin.y = params.objectCenter.y - params.ncells.y * params.dspace.y / 2.0;
@@ -117,6 +134,12 @@ namespace ipic3d {
 			out << "\tExternal magnetic field: " << props.externalMagneticField << std::endl;
 			out << "\tFields output cycle: " << props.FieldOutputCycle<< std::endl;
 			out << "\tParticles output cycle: " << props.ParticleOutputCycle<< std::endl;
+			out << "\tTile width: " << props.tileWidth << std::endl;
+			out << "\tDecentering parameter: " << props.theta << std::endl;
+			out << "\tCG tolerance: " << props.CGtol << std::endl;
+			out << "\tField solver tolerance: " << props.GMREStol << std::endl;
+			out << "\tField solver maximum iterations: " << props.fieldSolverMaxIterations << std::endl;
+			out << "\tPoisson correction cycle: " << props.poissonCorrectionCycle << std::endl;
 			return out;
 		}
 
@@ -141,4 +164,27 @@ namespace ipic3d {
 		return getOriginOfCell(pos, properties) + properties.cellWidth / 2.0;
 	}
 
+	/**
+	 * Determines whether the box of the cell at the given position intersects the planet, the sphere
+	 * of planetRadius around objectCenter absorbing particles. The test tolerates rounding errors, such
+	 * that particles inside the planet are never located in a cell which is not considered intersecting.
+	 */
+	bool intersectsPlanet(const coordinate_type& pos, const UniverseProperties& properties) {
+		const auto low = getOriginOfCell(pos, properties);
+
+		// the squared distance of the closest point of the box to the center of the planet
+		double dist2 = 0.0;
+		double maxWidth = 0.0;
+		for(int d = 0; d < 3; ++d) {
+			const double high = low[d] + properties.cellWidth[d];
+			const double center = properties.objectCenter[d];
+			const double diff = (center < low[d]) ? low[d] - center : ((center > high) ? center - high : 0.0);
+			dist2 += diff * diff;
+			maxWidth = std::max(maxWidth, properties.cellWidth[d]);
+		}
+
+		const double radius = properties.planetRadius + 1e-6 * maxWidth;
+		return dist2 <= radius * radius;
+	}
+
 }
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cmath>
+
+#include "allscale/utils/assert.h"
+
+namespace ipic3d {
+namespace utils {
+
+	/**
+	 * The outcome of an iterative solver.
+	 */
+	struct SolverStatistics {
+
+		// the number of iterations, e.g. CG steps or multigrid cycles
+		unsigned iterations;
+
+		// the norm of the final residual relative to the norm of the right-hand side
+		double residual;
+
+		// whether the residual reached the requested tolerance
+		bool converged;
+
+	};
+
+	/**
+	 * Solves the linear system A x = b for a symmetric positive definite operator A by the conjugate gradient
+	 * method (CG). Besides x and b, it keeps three vectors: the residual, the search direction and its image.
+	 *
+	 * Operators and vectors are opaque: vectors are copyable and the functions dotProduct(a,b),
+	 * addScaled(y,factor,x) (y += factor * x) and scale(x,factor) are located by argument-dependent lookup.
+	 * Thus, operators may be matrix-free and vector operations may be parallel.
+	 *
+	 * @param op the operator, invoked as op(x,y) to compute y = A x
+	 * @param b the right-hand side
+	 * @param x the initial guess, updated to the solution
+	 * @param tolerance the requested norm of the residual relative to the norm of b
+	 * @param maxIterations the maximum number of iterations, each applying the operator once
+	 */
+	template<typename Vector, typename Operator>
+	SolverStatistics solveCG(const Operator& op, const Vector& b, Vector& x, double tolerance, unsigned maxIterations) {
+
+		const double bNorm = std::sqrt(dotProduct(b, b));
+		if (bNorm == 0.0) {
+			scale(x, 0.0);
+			return { 0, 0.0, true };
+		}
+
+		// the residual of the initial guess, which is also the first search direction
+		Vector q = b;
+		op(x, q);
+		Vector r = b;
+		addScaled(r, -1.0, q);
+		Vector p = r;
+		double rr = dotProduct(r, r);
+
+		unsigned iterations = 0;
+		while(true) {
+			const double rNorm = std::sqrt(rr);
+			if (rNorm <= tolerance * bNorm || iterations >= maxIterations) {
+				return { iterations, rNorm / bNorm, rNorm <= tolerance * bNorm };
+			}
+			++iterations;
+
+			// the step along the search direction minimizing the energy norm of the error
+			op(p, q);
+			const double pq = dotProduct(p, q);
+			assert_lt(0.0, pq) << "Operator is not positive definite";
+			const double alpha = rr / pq;
+			addScaled(x, alpha, p);
+			addScaled(r, -alpha, q);
+
+			// the next search direction, conjugate to the previous ones
+			const double next = dotProduct(r, r);
+			scale(p, next / rr);
+			addScaled(p, 1.0, r);
+			rr = next;
+		}
+	}
+
+} // end namespace utils
+} // end namespace ipic3d
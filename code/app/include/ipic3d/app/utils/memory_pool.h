@@ -0,0 +1,243 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#ifdef _MSC_VER
+	#include <malloc.h>
+#endif
+
+#include "allscale/utils/assert.h"
+
+namespace ipic3d {
+namespace utils {
+
+	namespace detail {
+
+		/**
+		 * Allocates a block of memory of the given size aligned to the given boundary.
+		 */
+		inline void* allocateAligned(std::size_t alignment, std::size_t bytes) {
+			void* res = nullptr;
+			#ifdef _MSC_VER
+				res = _aligned_malloc(bytes, alignment);
+			#else
+				if (posix_memalign(&res, alignment, bytes) != 0) res = nullptr;
+			#endif
+			if (!res) throw std::bad_alloc();
+			return res;
+		}
+
+		/**
+		 * Frees a block of memory obtained through allocateAligned.
+		 */
+		inline void freeAligned(void* ptr) {
+			#ifdef _MSC_VER
+				_aligned_free(ptr);
+			#else
+				std::free(ptr);
+			#endif
+		}
+
+	}
+
+	/**
+	 * A pool of cache-line aligned memory blocks, recycling released blocks instead of returning
+	 * them to the system. Requests are rounded up to power-of-two size classes, each class
+	 * maintaining a list of free blocks. Pools are not synchronized; instead, each thread utilizes
+	 * its own pool (see getLocalPool), such that containers of particles which are re-allocated
+	 * while a time step is processed in parallel do not contend for the global heap. Blocks may be
+	 * released to the pool of any thread. Once containers reached their working size, time steps
+	 * thus do not cause any system allocations.
+	 */
+	class MemoryPool {
+
+	public:
+
+		// the alignment of all blocks (a cache line)
+		static constexpr std::size_t alignment = 64;
+
+		// the size of the smallest size class, in bytes
+		static constexpr std::size_t minBlockSize = alignment;
+
+		// the number of size classes, larger requests are forwarded to the system
+		static constexpr unsigned numSizeClasses = 21;
+
+		// the size of the largest size class, in bytes
+		static constexpr std::size_t maxBlockSize = minBlockSize << (numSizeClasses - 1);
+
+		// the maximum number of bytes retained in free blocks by a single pool
+		static constexpr std::size_t maxCachedBytes = std::size_t(256) << 20;
+
+	private:
+
+		// free blocks link to the next free block of their size class
+		struct FreeBlock {
+			FreeBlock* next;
+		};
+
+		// the list of free blocks of each size class
+		std::array<FreeBlock*,numSizeClasses> freeBlocks;
+
+		// the number of bytes retained in free blocks
+		std::size_t cachedBytes;
+
+		// the total number of blocks obtained from the system by all pools
+		static std::atomic<std::uint64_t>& getSystemAllocationCounter() {
+			static std::atomic<std::uint64_t> counter(0);
+			return counter;
+		}
+
+		/**
+		 * Obtains the size class of blocks of the given size.
+		 */
+		static unsigned getSizeClass(std::size_t bytes) {
+			unsigned res = 0;
+			while((minBlockSize << res) < bytes) {
+				++res;
+			}
+			return res;
+		}
+
+	public:
+
+		MemoryPool() : cachedBytes(0) {
+			freeBlocks.fill(nullptr);
+		}
+
+		MemoryPool(const MemoryPool&) = delete;
+		MemoryPool& operator=(const MemoryPool&) = delete;
+
+		~MemoryPool() {
+			release();
+		}
+
+		/**
+		 * Obtains the pool of the calling thread.
+		 */
+		static MemoryPool& getLocalPool() {
+			static thread_local MemoryPool pool;
+			return pool;
+		}
+
+		/**
+		 * Obtains the total number of blocks obtained from the system by all pools so far.
+		 */
+		static std::uint64_t getNumSystemAllocations() {
+			return getSystemAllocationCounter().load(std::memory_order_relaxed);
+		}
+
+		/**
+		 * Allocates a block of at least the given size, aligned to a cache line.
+		 */
+		void* allocate(std::size_t bytes) {
+			assert_lt(0u, bytes);
+
+			// large blocks are obtained from the system directly
+			if (bytes > maxBlockSize) {
+				getSystemAllocationCounter().fetch_add(1, std::memory_order_relaxed);
+				return detail::allocateAligned(alignment, bytes);
+			}
+
+			// recycle a free block if possible
+			const unsigned sizeClass = getSizeClass(bytes);
+			if (FreeBlock* block = freeBlocks[sizeClass]) {
+				freeBlocks[sizeClass] = block->next;
+				cachedBytes -= minBlockSize << sizeClass;
+				return block;
+			}
+
+			getSystemAllocationCounter().fetch_add(1, std::memory_order_relaxed);
+			return detail::allocateAligned(alignment, minBlockSize << sizeClass);
+		}
+
+		/**
+		 * Releases a block obtained from any pool through an allocation of the given size.
+		 */
+		void release(void* ptr, std::size_t bytes) {
+			if (!ptr) return;
+
+			// large blocks, and blocks exceeding the retention limit, are returned to the system
+			const std::size_t blockSize = (bytes > maxBlockSize) ? bytes : (minBlockSize << getSizeClass(bytes));
+			if (bytes > maxBlockSize || cachedBytes + blockSize > maxCachedBytes) {
+				detail::freeAligned(ptr);
+				return;
+			}
+
+			const unsigned sizeClass = getSizeClass(bytes);
+			FreeBlock* block = static_cast<FreeBlock*>(ptr);
+			block->next = freeBlocks[sizeClass];
+			freeBlocks[sizeClass] = block;
+			cachedBytes += blockSize;
+		}
+
+		/**
+		 * Returns all free blocks of this pool to the system.
+		 */
+		void release() {
+			for(auto& list : freeBlocks) {
+				while(list) {
+					FreeBlock* next = list->next;
+					detail::freeAligned(list);
+					list = next;
+				}
+			}
+			cachedBytes = 0;
+		}
+
+		/**
+		 * Obtains the number of bytes retained in free blocks by this pool.
+		 */
+		std::size_t getCachedBytes() const {
+			return cachedBytes;
+		}
+
+	};
+
+	/**
+	 * An allocator for standard containers obtaining its memory from the pool of the calling thread.
+	 */
+	template<typename T>
+	struct PoolAllocator {
+
+		using value_type = T;
+
+		PoolAllocator() = default;
+
+		template<typename U>
+		PoolAllocator(const PoolAllocator<U>&) {}
+
+		T* allocate(std::size_t n) {
+			return static_cast<T*>(MemoryPool::getLocalPool().allocate(n * sizeof(T)));
+		}
+
+		void deallocate(T* ptr, std::size_t n) {
+			MemoryPool::getLocalPool().release(ptr, n * sizeof(T));
+		}
+
+		template<typename U>
+		bool operator==(const PoolAllocator<U>&) const {
+			return true;
+		}
+
+		template<typename U>
+		bool operator!=(const PoolAllocator<U>&) const {
+			return false;
+		}
+
+	};
+
+	/**
+	 * A vector obtaining its memory from the pool of the calling thread, suitable for temporary
+	 * buffers of operations performed for each cell in each time step.
+	 */
+	template<typename T>
+	using PooledVector = std::vector<T,PoolAllocator<T>>;
+
+} // end namespace utils
+} // end namespace ipic3d
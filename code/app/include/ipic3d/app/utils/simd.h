@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+
+/**
+ * Vectorized kernels are written once against a generic value type V, which is either
+ * a plain double (scalar fallback) or a GCC/Clang vector extension type. The vector
+ * variants are compiled for their target instruction set through function attributes
+ * and selected at run time based on the features of the executing CPU.
+ *
+ * Floating point contraction (FMA) is disabled for all kernel instantiations, such that
+ * each lane of a vector variant produces bit-wise the same result as the scalar fallback.
+ */
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#define IPIC3D_X86_SIMD 1
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define IPIC3D_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+	#define IPIC3D_ALWAYS_INLINE inline
+#endif
+
+#if defined(__clang__)
+	#define IPIC3D_SIMD_FUNCTION(ISA) __attribute__((target(ISA)))
+	#define IPIC3D_SCALAR_FUNCTION
+	#define IPIC3D_NO_FP_CONTRACT _Pragma("clang fp contract(off)")
+#elif defined(__GNUC__)
+	#define IPIC3D_SIMD_FUNCTION(ISA) __attribute__((target(ISA), optimize("fp-contract=off")))
+	#define IPIC3D_SCALAR_FUNCTION __attribute__((optimize("fp-contract=off")))
+	#define IPIC3D_NO_FP_CONTRACT
+#else
+	#define IPIC3D_SCALAR_FUNCTION
+	#define IPIC3D_NO_FP_CONTRACT
+#endif
+
+namespace ipic3d {
+namespace utils {
+namespace simd {
+
+	/**
+	 * The instruction set extensions vectorized kernels may be dispatched to.
+	 */
+	enum class Level {
+		Scalar,
+		AVX2,
+		AVX512
+	};
+
+	std::ostream& operator<<(std::ostream& out, Level level) {
+		switch(level) {
+			case Level::Scalar: return out << "scalar";
+			case Level::AVX2:   return out << "AVX2";
+			case Level::AVX512: return out << "AVX-512";
+		}
+		return out << "unknown";
+	}
+
+	/**
+	 * Determines the most capable instruction set extension supported by the executing CPU.
+	 */
+	Level getSupportedLevel() {
+		static const Level level = []() {
+			#ifdef IPIC3D_X86_SIMD
+				__builtin_cpu_init();
+				if (__builtin_cpu_supports("avx512f")) return Level::AVX512;
+				if (__builtin_cpu_supports("avx2")) return Level::AVX2;
+			#endif
+			return Level::Scalar;
+		}();
+		return level;
+	}
+
+	#ifdef IPIC3D_X86_SIMD
+
+		// 4 doubles, processed by AVX2 instructions
+		typedef double double4 __attribute__((vector_size(32)));
+
+		// 8 doubles, processed by AVX-512 instructions
+		typedef double double8 __attribute__((vector_size(64)));
+
+	#endif
+
+	/**
+	 * The number of lanes of the given value type.
+	 */
+	template<typename V>
+	struct width {
+		static constexpr int value = sizeof(V) / sizeof(double);
+	};
+
+	/**
+	 * Loads a value from the given (padded) array position.
+	 * Values are handled through reference parameters to keep vector types off function signatures.
+	 */
+	template<typename V>
+	IPIC3D_ALWAYS_INLINE void load(V& res, const double* src) {
+		std::memcpy(&res, src, sizeof(V));
+	}
+
+	/**
+	 * Stores a value to the given (padded) array position.
+	 */
+	template<typename V>
+	IPIC3D_ALWAYS_INLINE void store(double* trg, const V& value) {
+		std::memcpy(trg, &value, sizeof(V));
+	}
+
+	/**
+	 * Loads a value from the given (padded) single precision array position, widening each lane.
+	 */
+	template<typename V>
+	IPIC3D_ALWAYS_INLINE void load(V& res, const float* src) {
+		double lanes[width<V>::value];
+		for(int i = 0; i < width<V>::value; ++i) {
+			lanes[i] = src[i];
+		}
+		load(res, lanes);
+	}
+
+	/**
+	 * Stores a value to the given (padded) single precision array position, rounding each lane.
+	 */
+	template<typename V>
+	IPIC3D_ALWAYS_INLINE void store(float* trg, const V& value) {
+		double lanes[width<V>::value];
+		store(lanes, value);
+		for(int i = 0; i < width<V>::value; ++i) {
+			trg[i] = float(lanes[i]);
+		}
+	}
+
+	/**
+	 * Sets all lanes of the given value to the given scalar.
+	 */
+	template<typename V>
+	IPIC3D_ALWAYS_INLINE void broadcast(V& res, double value) {
+		double lanes[width<V>::value];
+		for(int i = 0; i < width<V>::value; ++i) {
+			lanes[i] = value;
+		}
+		load(res, lanes);
+	}
+
+	/**
+	 * Sets the lanes of the given value to the consecutive sequence first, first + 1, ...
+	 */
+	template<typename V>
+	IPIC3D_ALWAYS_INLINE void iota(V& res, double first) {
+		double lanes[width<V>::value];
+		for(int i = 0; i < width<V>::value; ++i) {
+			lanes[i] = first + i;
+		}
+		load(res, lanes);
+	}
+
+	/**
+	 * Computes the maximum over all lanes of the given value.
+	 */
+	template<typename V>
+	IPIC3D_ALWAYS_INLINE double reduceMax(const V& value) {
+		double lanes[width<V>::value];
+		store(lanes, value);
+		double res = lanes[0];
+		for(int i = 1; i < width<V>::value; ++i) {
+			res = (lanes[i] > res) ? lanes[i] : res;
+		}
+		return res;
+	}
+
+	/**
+	 * Computes the largest integral value not greater than the given value, for values in [0,2^51).
+	 * Implemented through plain arithmetic, such that scalar and vector lanes agree.
+	 */
+	template<typename V>
+	IPIC3D_ALWAYS_INLINE void floorNonNegative(V& res, const V& value) {
+		const double shift = 4503599627370496.0; // 2^52
+		V rounded = (value + shift) - shift;
+		res = (rounded > value) ? (rounded - 1.0) : rounded;
+	}
+
+	/**
+	 * Computes 1/sqrt(value) for positive, normal values without a division or square root.
+	 * An initial estimate obtained from the bit pattern of the value is refined by four
+	 * Newton iterations, leaving a relative error within a few units in the last place.
+	 */
+	template<typename V>
+	IPIC3D_ALWAYS_INLINE void inverseSqrt(V& res, const V& value) {
+		constexpr int W = width<V>::value;
+
+		// the initial estimate, with a relative error below 4%
+		double lanes[W];
+		store(lanes, value);
+		for(int i = 0; i < W; ++i) {
+			std::uint64_t bits;
+			std::memcpy(&bits, &lanes[i], sizeof(bits));
+			bits = 0x5FE6EB50C7B537A9ull - (bits >> 1);
+			std::memcpy(&lanes[i], &bits, sizeof(bits));
+		}
+		V y;
+		load(y, lanes);
+
+		// each iteration roughly doubles the number of correct digits
+		V half = value * 0.5;
+		for(int i = 0; i < 4; ++i) {
+			y = y * (1.5 - half * y * y);
+		}
+		res = y;
+	}
+
+} // end namespace simd
+} // end namespace utils
+} // end namespace ipic3d
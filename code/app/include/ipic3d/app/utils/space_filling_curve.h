@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "allscale/api/user/algorithm/pfor.h"
+#include "allscale/utils/assert.h"
+
+#include "ipic3d/app/utils/points.h"
+
+namespace ipic3d {
+namespace utils {
+
+	/**
+	 * The width of the blocks of grid points processed by a single work item of pforInMortonOrder.
+	 */
+	constexpr std::int64_t mortonBlockWidth = 4;
+
+	/**
+	 * Computes the Morton code of the given (non-negative) grid point by interleaving the bits of
+	 * its coordinates, the x coordinate being the most significant. Up to 21 bits per coordinate
+	 * are covered. Points which are close in space tend to have close codes.
+	 */
+	std::uint64_t getMortonCode(const Coordinate<3>& pos) {
+		// spreads the lower 21 bits of the given value such that two zero bits follow each bit
+		auto spread = [](std::uint64_t v) {
+			v &= 0x1FFFFF;
+			v = (v | (v << 32)) & 0x001F00000000FFFFull;
+			v = (v | (v << 16)) & 0x001F0000FF0000FFull;
+			v = (v | (v << 8))  & 0x100F00F00F00F00Full;
+			v = (v | (v << 4))  & 0x10C30C30C30C30C3ull;
+			v = (v | (v << 2))  & 0x1249249249249249ull;
+			return v;
+		};
+		return (spread(std::uint64_t(pos.x)) << 2) | (spread(std::uint64_t(pos.y)) << 1) | spread(std::uint64_t(pos.z));
+	}
+
+	namespace detail {
+
+		template<typename Op>
+		void forEachInMortonOrder(const Coordinate<3>& begin, const Coordinate<3>& end, const Coordinate<3>& low, std::int64_t width, const Op& op) {
+
+			// skip octants outside of the range
+			for(int d = 0; d < 3; ++d) {
+				if (low[d] >= end[d] || low[d] + width <= begin[d]) return;
+			}
+
+			if (width == 1) {
+				op(low);
+				return;
+			}
+
+			// visit the octants in the order of their Morton codes
+			const std::int64_t half = width / 2;
+			for(int c = 0; c < 8; ++c) {
+				Coordinate<3> child = low;
+				child.x += ((c >> 2) & 1) * half;
+				child.y += ((c >> 1) & 1) * half;
+				child.z += (c & 1) * half;
+				forEachInMortonOrder(begin, end, child, half, op);
+			}
+		}
+
+	}
+
+	/**
+	 * Applies the given operation to all grid points within [begin,end) in ascending order of
+	 * their Morton code.
+	 */
+	template<typename Op>
+	void forEachInMortonOrder(const Coordinate<3>& begin, const Coordinate<3>& end, const Op& op) {
+		for(int d = 0; d < 3; ++d) {
+			if (!(begin[d] < end[d])) return;
+		}
+
+		// the smallest power of two aligned box covering the range
+		std::int64_t width = 1;
+		while(width < end.x || width < end.y || width < end.z) {
+			width *= 2;
+		}
+		detail::forEachInMortonOrder(begin, end, Coordinate<3>(0), width, op);
+	}
+
+	/**
+	 * Obtains the number of blocks of width^3 points covering the range [begin,end).
+	 */
+	Size<3> getNumBlocks(const Coordinate<3>& begin, const Coordinate<3>& end, std::int64_t width = mortonBlockWidth) {
+		assert_lt(0, width);
+		Size<3> res;
+		for(int d = 0; d < 3; ++d) {
+			res[d] = std::max<std::int64_t>(0, (end[d] - begin[d] + width - 1) / width);
+		}
+		return res;
+	}
+
+	/**
+	 * A parallel loop over the blocks of width^3 grid points covering the range [begin,end),
+	 * invoking the given body with the range [low,high) of each block, clipped to the range.
+	 * The returned loop reference covers the grid of blocks, thus dependencies may only be
+	 * established between loops over the same range and width. Since the direct neighbors of
+	 * any point are located in the same or a neighboring block, a neighborhood_sync between
+	 * such loops covers them. It does not cover periodic neighbors across the boundary of the
+	 * range, unless there are at most two blocks along the respective dimension.
+	 */
+	template<typename Body, typename ... Dependency>
+	auto pforBlocks(const Coordinate<3>& begin, const Coordinate<3>& end, std::int64_t width, const Body& body, const Dependency& ... dependency) {
+		return allscale::api::user::algorithm::pfor(Coordinate<3>(0), getNumBlocks(begin, end, width), [=](const Coordinate<3>& block) {
+			Coordinate<3> low;
+			Coordinate<3> high;
+			for(int d = 0; d < 3; ++d) {
+				low[d] = begin[d] + block[d] * width;
+				high[d] = std::min(low[d] + width, end[d]);
+			}
+			body(low, high);
+		}, dependency...);
+	}
+
+	/**
+	 * A parallel loop over the grid points within [begin,end), processing blocks of
+	 * mortonBlockWidth^3 points per work item. The points of each block are visited in
+	 * the order of their Morton code, such that consecutive points touch neighboring
+	 * data. Like for pforBlocks, the returned loop reference covers the grid of blocks.
+	 */
+	template<typename Body, typename ... Dependency>
+	auto pforInMortonOrder(const Coordinate<3>& begin, const Coordinate<3>& end, const Body& body, const Dependency& ... dependency) {
+		return pforBlocks(begin, end, mortonBlockWidth, [=](const Coordinate<3>& low, const Coordinate<3>& high) {
+			forEachInMortonOrder(low, high, body);
+		}, dependency...);
+	}
+
+} // end namespace utils
+} // end namespace ipic3d
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "allscale/api/user/algorithm/pfor.h"
+#include "allscale/api/user/algorithm/preduce.h"
+#include "allscale/api/user/data/grid.h"
+#include "allscale/utils/assert.h"
+
+#include "ipic3d/app/halo.h"
+#include "ipic3d/app/particle_store.h"
+#include "ipic3d/app/utils/memory_pool.h"
+#include "ipic3d/app/utils/points.h"
+#include "ipic3d/app/vector.h"
+
+namespace ipic3d {
+
+	/**
+	 * A 3D grid of vectors stored as a structure of arrays: each component is maintained in a plane
+	 * of its own, in which the values along the z dimension are contiguous. Thus, kernels processing
+	 * runs of consecutive nodes along z (pencils) load and store vectors of values of the same
+	 * component. Pencils start at cache line boundaries.
+	 *
+	 * Like a Grid, the field is indexed by coordinates; the element accessors return proxies
+	 * forwarding to the component planes.
+	 */
+	class VectorField {
+
+	public:
+
+		// the number of doubles pencils are aligned to (a cache line)
+		static constexpr std::int64_t alignment = 8;
+
+	private:
+
+		// the number of vectors along each dimension
+		utils::Size<3> extent;
+
+		// the distance between the starts of consecutive pencils
+		std::int64_t stride;
+
+		// the distance between the starts of consecutive component planes
+		std::int64_t planeSize;
+
+		// the component planes, one after the other
+		utils::PooledVector<double> values;
+
+	public:
+
+		explicit VectorField(const utils::Size<3>& size = utils::Size<3>(0))
+			: extent(size),
+			  stride(((size.z + alignment - 1) / alignment) * alignment),
+			  planeSize(size.x * size.y * stride),
+			  values(std::size_t(3 * planeSize), 0.0) {
+			assert_true(utils::Size<3>(0).dominatedBy(size)) << "Invalid size " << size;
+		}
+
+		const utils::Size<3>& size() const {
+			return extent;
+		}
+
+		/**
+		 * Obtains the distance between the starts of consecutive pencils.
+		 */
+		std::int64_t getStride() const {
+			return stride;
+		}
+
+		/**
+		 * Obtains the plane of the given component, 0 for x, 1 for y and 2 for z.
+		 */
+		double* data(int component) {
+			assert_true(0 <= component && component < 3) << component;
+			return values.data() + component * planeSize;
+		}
+
+		const double* data(int component) const {
+			assert_true(0 <= component && component < 3) << component;
+			return values.data() + component * planeSize;
+		}
+
+		/**
+		 * Obtains the start of the pencil of the given component at the given x and y coordinates.
+		 */
+		double* pencil(int component, std::int64_t x, std::int64_t y) {
+			assert_true(0 <= x && x < extent.x && 0 <= y && y < extent.y) << "Pencil " << x << "," << y << " is outside field of size " << extent;
+			return data(component) + (x * extent.y + y) * stride;
+		}
+
+		const double* pencil(int component, std::int64_t x, std::int64_t y) const {
+			assert_true(0 <= x && x < extent.x && 0 <= y && y < extent.y) << "Pencil " << x << "," << y << " is outside field of size " << extent;
+			return data(component) + (x * extent.y + y) * stride;
+		}
+
+		// -- element access --
+
+		Vector3Ref<double&> operator[](const utils::Coordinate<3>& pos) {
+			const std::int64_t i = getIndex(pos);
+			return { data(0)[i], data(1)[i], data(2)[i] };
+		}
+
+		Vector3<double> operator[](const utils::Coordinate<3>& pos) const {
+			const std::int64_t i = getIndex(pos);
+			return { data(0)[i], data(1)[i], data(2)[i] };
+		}
+
+	private:
+
+		std::int64_t getIndex(const utils::Coordinate<3>& pos) const {
+			assert_true(pos.strictlyDominatedBy(extent)) << "Position " << pos << " is outside field of size " << extent;
+			return (pos.x * extent.y + pos.y) * stride + pos.z;
+		}
+
+	};
+
+	/**
+	 * Copies the given vector member of all elements of the given grid into the given field of the same size.
+	 */
+	template<typename T>
+	void loadVectorField(const allscale::api::user::data::Grid<T,3>& grid, Vector3<double> T::* member, VectorField& res) {
+		assert_true(grid.size() == res.size()) << "Expected field of size " << grid.size() << " but got " << res.size();
+		allscale::api::user::algorithm::pfor(grid.size(), [&](const utils::Coordinate<3>& pos) {
+			res[pos] = grid[pos].*member;
+		});
+	}
+
+	/**
+	 * Copies the given field into the given vector member of all elements of the given grid of the same size.
+	 */
+	template<typename T>
+	void storeVectorField(const VectorField& field, allscale::api::user::data::Grid<T,3>& grid, Vector3<double> T::* member) {
+		assert_true(grid.size() == field.size()) << "Expected grid of size " << field.size() << " but got " << grid.size();
+		allscale::api::user::algorithm::pfor(grid.size(), [&](const utils::Coordinate<3>& pos) {
+			grid[pos].*member = field[pos];
+		});
+	}
+
+	/**
+	 * Updates the ghost layer of the given field by replicating its interior of the given size under
+	 * periodic boundaries, see getHaloRegions.
+	 */
+	void updatePeriodicHalo(VectorField& field, const utils::Size<3>& period) {
+		auto regions = getHaloRegions(field.size(), period);
+		allscale::api::user::algorithm::pfor(regions, [&](const HaloRegion& region) {
+			allscale::api::user::algorithm::pfor(region.begin, region.end, [&](const utils::Coordinate<3>& pos) {
+				field[pos] = field[pos + region.offset];
+			});
+		});
+	}
+
+	/**
+	 * Updates the one element wide ghost layer of the given field under periodic boundaries.
+	 */
+	void updatePeriodicHalo(VectorField& field) {
+		updatePeriodicHalo(field, field.size() - utils::Size<3>(2));
+	}
+
+	/**
+	 * Sets the ghost layer of the given field, surrounding its interior of the given size, to zero, such
+	 * that the field only covers its interior.
+	 */
+	void clearHalo(VectorField& field, const utils::Size<3>& period) {
+		auto regions = getHaloRegions(field.size(), period);
+		allscale::api::user::algorithm::pfor(regions, [&](const HaloRegion& region) {
+			allscale::api::user::algorithm::pfor(region.begin, region.end, [&](const utils::Coordinate<3>& pos) {
+				field[pos] = Vector3<double>(0.0);
+			});
+		});
+	}
+
+	/**
+	 * Sets the one element wide ghost layer of the given field to zero.
+	 */
+	void clearHalo(VectorField& field) {
+		clearHalo(field, field.size() - utils::Size<3>(2));
+	}
+
+	namespace detail {
+
+		/**
+		 * A parallel loop over the pencils of the given field, invoking the given operation with the
+		 * offset of the pencil within the component planes.
+		 */
+		template<typename Op>
+		void forAllPencils(const VectorField& field, const Op& op) {
+			const auto& size = field.size();
+			allscale::api::user::algorithm::pfor(utils::Coordinate<3>(0), utils::Coordinate<3>{ size.x, size.y, 1 }, [&](const utils::Coordinate<3>& pos) {
+				op((pos.x * size.y + pos.y) * field.getStride());
+			});
+		}
+
+	}
+
+	/**
+	 * Computes the scalar product of the given fields of the same size, interpreting them as vectors of
+	 * all their components. Elements of the ghost layer are included, thus fields only covering their
+	 * interior are to be cleared there.
+	 */
+	double dotProduct(const VectorField& a, const VectorField& b) {
+		assert_true(a.size() == b.size()) << "Expected fields of equal size, but got " << a.size() << " and " << b.size();
+		const auto& size = a.size();
+		auto map = [&](const utils::Coordinate<3>& pos, double& res) {
+			const std::int64_t offset = (pos.x * size.y + pos.y) * a.getStride();
+			for(int d = 0; d < 3; ++d) {
+				const double* x = a.data(d) + offset;
+				const double* y = b.data(d) + offset;
+				for(std::int64_t z = 0; z < size.z; ++z) {
+					res += x[z] * y[z];
+				}
+			}
+		};
+		auto reduce = [](const double& x, const double& y) { return x + y; };
+		auto init = []() { return 0.0; };
+		return allscale::api::user::algorithm::preduce(utils::Coordinate<3>(0), utils::Coordinate<3>{ size.x, size.y, 1 }, map, reduce, init).get();
+	}
+
+	/**
+	 * Computes the Euclidean norm of the given field, see dotProduct.
+	 */
+	double norm(const VectorField& a) {
+		return std::sqrt(dotProduct(a, a));
+	}
+
+	/**
+	 * Adds the given multiple of the field x to the field y of the same size.
+	 */
+	void addScaled(VectorField& y, double factor, const VectorField& x) {
+		assert_true(x.size() == y.size()) << "Expected fields of equal size, but got " << x.size() << " and " << y.size();
+		const std::int64_t n = x.size().z;
+		detail::forAllPencils(x, [&](std::int64_t offset) {
+			for(int d = 0; d < 3; ++d) {
+				const double* src = x.data(d) + offset;
+				double* trg = y.data(d) + offset;
+				for(std::int64_t z = 0; z < n; ++z) {
+					trg[z] += factor * src[z];
+				}
+			}
+		});
+	}
+
+	/**
+	 * Multiplies each component of all elements of the given field by the respective component of the given factor.
+	 */
+	void scale(VectorField& field, const Vector3<double>& factor) {
+		const std::int64_t n = field.size().z;
+		detail::forAllPencils(field, [&](std::int64_t offset) {
+			for(int d = 0; d < 3; ++d) {
+				double* trg = field.data(d) + offset;
+				for(std::int64_t z = 0; z < n; ++z) {
+					trg[z] *= factor[d];
+				}
+			}
+		});
+	}
+
+	/**
+	 * Multiplies all elements of the given field by the given factor.
+	 */
+	void scale(VectorField& field, double factor) {
+		scale(field, Vector3<double>(factor));
+	}
+
+} // end namespace ipic3d
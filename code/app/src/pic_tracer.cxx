@@ -10,6 +10,7 @@
 #include "allscale/api/user/algorithm/preduce.h"
 
 #include "ipic3d/app/cell.h"
+#include "ipic3d/app/dipole_field.h"
 #include "ipic3d/app/field.h"
 #include "ipic3d/app/particle.h"
 #include "ipic3d/app/universe_properties.h"
@@ -78,6 +79,7 @@ void traceParticle(Particle p, int T, const UniverseProperties& config, int fram
 
 	// extract some properties
 	auto dt = config.dt;
+	const DipoleField dipole(config.externalMagneticField, config.planetRadius);
 
 	// get universe size
 	auto universeSize = elementwiseProduct(config.cellWidth, config.size);
@@ -104,12 +106,9 @@ void traceParticle(Particle p, int T, const UniverseProperties& config, int fram
 		auto pos = getCellCoordinates(config,p);
 
 		// calculate 3 Cartesian components of the magnetic field
-		double fac1 =  -config.externalMagneticField.z * pow(config.planetRadius, 3) / pow(allscale::utils::sumOfSquares(p.position), 2.5);
 		Vector3<double> E, B;
 		E = {0.0, 0.0, 0.0};
-		B.x = 3.0 * p.position.x * p.position.z * fac1;
-		B.y = 3.0 * p.position.y * p.position.z * fac1;
-		B.z = (2.0 * pow(p.position.z, 2) - pow(p.position.x, 2) - pow(p.position.y, 2)) * fac1;
+		B = dipole(p.position);
 			
 		// adaptive sub-cycling for computing velocity
 		double B_mag = allscale::utils::sumOfSquares(B);
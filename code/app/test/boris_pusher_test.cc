@@ -0,0 +1,379 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "ipic3d/app/boris_pusher.h"
+
+#include "random_particles.h"
+
+namespace ipic3d {
+
+	using utils::simd::Level;
+
+	// the box of the random particles of these tests, around the center of the dipole
+	const Vector3<double> boxLow { -10.0, -10.0, -10.0 };
+	const Vector3<double> boxWidth { 20.0, 20.0, 20.0 };
+
+	DipolePushParameters getTestParameters() {
+		DipolePushParameters params;
+		params.magneticFieldTemp = -1e-1 * pow(2.0, 3);
+		params.E = { 0.01, -0.02, 0.03 };
+		params.dt = 0.1;
+		params.speedOfLight = 1.0;
+		return params;
+	}
+
+	TEST(BorisPusher, ScalarMatchesParticleUpdate) {
+
+		auto params = getTestParameters();
+		auto particles = createRandomParticles<BasicParticleStore<double>>(37, boxLow, boxWidth);
+		auto reference = particles;
+
+		pushParticlesInDipoleField(particles, params, Level::Scalar);
+
+		// move the reference particles one at a time
+		for(std::size_t i = 0; i < reference.size(); i++) {
+			Particle p = reference[i];
+
+			Vector3<double> B = DipoleField(params.magneticFieldTemp)(p.position);
+
+			double B_mag = allscale::utils::sumOfSquares(B);
+			double dt_sub = M_PI * params.speedOfLight / (4.0 * fabs(p.qom) * B_mag);
+			int sub_cycles = int(params.dt / dt_sub) + 1;
+			sub_cycles = std::min(sub_cycles, 100);
+			dt_sub = params.dt / double(sub_cycles);
+
+			for(int cyc_cnt = 0; cyc_cnt < sub_cycles; cyc_cnt++) {
+				p.updateVelocity(params.E, B, dt_sub);
+				p.updatePosition(dt_sub);
+			}
+
+			// the results have to be bit-wise identical
+			Particle res = particles[i];
+			EXPECT_EQ(p.position, res.position) << "Particle " << i;
+			EXPECT_EQ(p.velocity, res.velocity) << "Particle " << i;
+		}
+	}
+
+	TEST(BorisPusher, VectorizedMatchesScalar) {
+
+		auto params = getTestParameters();
+
+		for(Level level : { Level::AVX2, Level::AVX512 }) {
+
+			// skip extensions not supported by this CPU
+			if (utils::simd::getSupportedLevel() < level) continue;
+
+			// test various sizes to cover partially filled vectors
+			for(std::size_t num : { 1, 3, 4, 7, 8, 9, 16, 31 }) {
+				auto scalar = createRandomParticles(num, boxLow, boxWidth, std::uint32_t(num));
+				auto vector = scalar;
+
+				for(int i = 0; i < 5; i++) {
+					pushParticlesInDipoleField(scalar, params, Level::Scalar);
+					pushParticlesInDipoleField(vector, params, level);
+				}
+
+				ASSERT_EQ(scalar.size(), vector.size());
+				for(std::size_t i = 0; i < num; i++) {
+					Particle a = scalar[i];
+					Particle b = vector[i];
+					EXPECT_EQ(a.position, b.position) << "Level " << level << ", particle " << i << " of " << num;
+					EXPECT_EQ(a.velocity, b.velocity) << "Level " << level << ", particle " << i << " of " << num;
+				}
+			}
+		}
+	}
+
+	TEST(BorisPusher, RelativePositions) {
+
+		auto params = getTestParameters();
+		auto absolute = createRandomParticles<BasicParticleStore<double>>(31, boxLow, boxWidth);
+
+		// store the same particles relative to some frame
+		auto relative = absolute;
+		relative.setFrame({ -10.0, -10.0, -10.0 }, { 20.0, 20.0, 20.0 });
+
+		for(int i = 0; i < 5; i++) {
+			pushParticlesInDipoleField(absolute, params, Level::Scalar);
+			pushParticlesInDipoleField(relative, params, Level::Scalar);
+		}
+
+		// the frame does not alter the result beyond rounding errors
+		for(std::size_t i = 0; i < absolute.size(); i++) {
+			Particle a = absolute[i];
+			Particle b = relative[i];
+			EXPECT_LT(norm(a.position - b.position), 1e-9 * (1.0 + norm(a.position))) << "Particle " << i;
+			EXPECT_LT(norm(a.velocity - b.velocity), 1e-9 * (1.0 + norm(a.velocity))) << "Particle " << i;
+		}
+
+		// and vectorized versions convert positions the same way
+		for(Level level : { Level::AVX2, Level::AVX512 }) {
+			if (utils::simd::getSupportedLevel() < level) continue;
+
+			auto vector = createRandomParticles<BasicParticleStore<double>>(31, boxLow, boxWidth);
+			vector.setFrame({ -10.0, -10.0, -10.0 }, { 20.0, 20.0, 20.0 });
+			for(int i = 0; i < 5; i++) {
+				pushParticlesInDipoleField(vector, params, level);
+			}
+
+			for(std::size_t i = 0; i < relative.size(); i++) {
+				EXPECT_EQ(relative.data(BasicParticleStore<double>::X)[i], vector.data(BasicParticleStore<double>::X)[i]) << "Level " << level << ", particle " << i;
+				EXPECT_EQ(relative.data(BasicParticleStore<double>::VZ)[i], vector.data(BasicParticleStore<double>::VZ)[i]) << "Level " << level << ", particle " << i;
+			}
+		}
+	}
+
+	TEST(BorisPusher, SinglePrecision) {
+
+		auto params = getTestParameters();
+		auto reference = createRandomParticles<BasicParticleStore<double>>(31, boxLow, boxWidth);
+		auto scalar = createRandomParticles<BasicParticleStore<float>>(31, boxLow, boxWidth);
+
+		for(int i = 0; i < 5; i++) {
+			pushParticlesInDipoleField(reference, params, Level::Scalar);
+			pushParticlesInDipoleField(scalar, params, Level::Scalar);
+		}
+
+		// results are close to the double precision version
+		for(std::size_t i = 0; i < reference.size(); i++) {
+			Particle a = reference[i];
+			Particle b = scalar[i];
+			EXPECT_LT(norm(a.position - b.position), 1e-4 * (1.0 + norm(a.position))) << "Particle " << i;
+			EXPECT_LT(norm(a.velocity - b.velocity), 1e-4 * (1.0 + norm(a.velocity))) << "Particle " << i;
+		}
+
+		// and vectorized versions still agree bit-wise with the scalar version
+		for(Level level : { Level::AVX2, Level::AVX512 }) {
+			if (utils::simd::getSupportedLevel() < level) continue;
+
+			auto vector = createRandomParticles<BasicParticleStore<float>>(31, boxLow, boxWidth);
+			for(int i = 0; i < 5; i++) {
+				pushParticlesInDipoleField(vector, params, level);
+			}
+
+			for(std::size_t i = 0; i < scalar.size(); i++) {
+				Particle a = scalar[i];
+				Particle b = vector[i];
+				EXPECT_EQ(a.position, b.position) << "Level " << level << ", particle " << i;
+				EXPECT_EQ(a.velocity, b.velocity) << "Level " << level << ", particle " << i;
+			}
+		}
+	}
+
+	/**
+	 * Obtains the index of the particle of the given store located at the given position.
+	 */
+	template<typename T>
+	std::size_t findParticle(const BasicParticleStore<T>& particles, const Vector3<double>& position) {
+		for(std::size_t i = 0; i < particles.size(); i++) {
+			if (Particle(particles[i]).position == position) return i;
+		}
+		return particles.size();
+	}
+
+	TEST(BorisPusher, GroupBySubCycles) {
+
+		// a strong field, such that particles require varying numbers of sub-cycles
+		auto params = getTestParameters();
+		params.magneticFieldTemp = -1e2;
+
+		// particles of a single species, identified by their (unique) position
+		auto particles = createRandomParticles<BasicParticleStore<double>>(100, boxLow, boxWidth, 7);
+		for(std::size_t i = 0; i < particles.size(); i++) {
+			particles[i].q = -1.0;
+			particles[i].qom = -25.0;
+		}
+		const std::uint8_t* ids = particles.getSpeciesIds();
+		ASSERT_TRUE(std::all_of(ids, ids + particles.size(), [&](std::uint8_t id) { return id == ids[0]; }));
+		auto reference = particles;
+
+		// group particles
+		groupParticlesBySubCycles(particles, params);
+		ASSERT_EQ(reference.size(), particles.size());
+
+		// all dispatch levels agree on the number of sub-cycles
+		std::vector<std::uint8_t> counts(particles.size());
+		countSubCyclesInDipoleField(particles, params, counts.data(), Level::Scalar);
+		for(Level level : { Level::AVX2, Level::AVX512 }) {
+			if (utils::simd::getSupportedLevel() < level) continue;
+			std::vector<std::uint8_t> other(particles.size());
+			countSubCyclesInDipoleField(particles, params, other.data(), level);
+			EXPECT_EQ(counts, other) << "Level " << level;
+		}
+
+		// particles are ordered by their number of sub-cycles
+		EXPECT_TRUE(std::is_sorted(counts.begin(), counts.end()));
+		EXPECT_LT(counts.front(), counts.back());
+
+		// grouping again retains the order
+		auto grouped = particles;
+		groupParticlesBySubCycles(grouped, params);
+		for(std::size_t i = 0; i < particles.size(); i++) {
+			EXPECT_EQ(Particle(particles[i]).position, Particle(grouped[i]).position);
+		}
+
+		// moving grouped particles produces the same result for each particle
+		std::vector<std::size_t> origin(particles.size());
+		for(std::size_t i = 0; i < particles.size(); i++) {
+			origin[i] = findParticle(reference, Particle(particles[i]).position);
+			ASSERT_LT(origin[i], reference.size());
+		}
+		pushParticlesInDipoleField(reference, params);
+		pushParticlesInDipoleField(particles, params);
+		for(std::size_t i = 0; i < particles.size(); i++) {
+			Particle p = particles[i];
+			Particle r = reference[origin[i]];
+			EXPECT_EQ(r.position, p.position) << "Particle " << i;
+			EXPECT_EQ(r.velocity, p.velocity) << "Particle " << i;
+		}
+	}
+
+	TEST(BorisPusher, GroupBySpecies) {
+
+		// a strong field, such that particles require varying numbers of sub-cycles
+		auto params = getTestParameters();
+		params.magneticFieldTemp = -1e2;
+
+		// electrons and protons, alternating, stored relative to a frame not representable exactly
+		auto particles = createRandomParticles<BasicParticleStore<double>>(101, boxLow, boxWidth, 3);
+		particles.setFrame({ -10.3, -9.7, -10.1 }, { 20.7, 19.9, 20.3 });
+		ASSERT_EQ(2u, particles.getSpecies().size());
+		auto reference = particles;
+
+		groupParticlesBySubCycles(particles, params);
+		ASSERT_EQ(reference.size(), particles.size());
+
+		// particles are grouped by species first
+		const std::uint8_t* ids = particles.getSpeciesIds();
+		EXPECT_TRUE(std::is_sorted(ids, ids + particles.size()));
+		EXPECT_NE(ids[0], ids[particles.size() - 1]);
+
+		// and by their number of sub-cycles within each species second
+		std::vector<std::uint8_t> counts(particles.size());
+		countSubCyclesInDipoleField(particles, params, counts.data(), Level::Scalar);
+		const std::size_t electrons = std::size_t(std::upper_bound(ids, ids + particles.size(), ids[0]) - ids);
+		EXPECT_EQ(51u, electrons);
+		EXPECT_TRUE(std::is_sorted(counts.begin(), counts.begin() + electrons));
+		EXPECT_TRUE(std::is_sorted(counts.begin() + electrons, counts.end()));
+
+		// pushing each species on its own produces the same result for each particle on all levels
+		std::vector<std::size_t> origin(particles.size());
+		for(std::size_t i = 0; i < particles.size(); i++) {
+			origin[i] = findParticle(reference, Particle(particles[i]).position);
+			ASSERT_LT(origin[i], reference.size());
+		}
+		pushParticlesInDipoleField(reference, params, Level::Scalar);
+		for(Level level : { Level::Scalar, Level::AVX2, Level::AVX512 }) {
+			if (utils::simd::getSupportedLevel() < level) continue;
+			auto pushed = particles;
+			pushParticlesInDipoleField(pushed, params, level);
+			for(std::size_t i = 0; i < pushed.size(); i++) {
+				Particle p = pushed[i];
+				Particle r = reference[origin[i]];
+				EXPECT_EQ(r.position, p.position) << "Level " << level << ", particle " << i;
+				EXPECT_EQ(r.velocity, p.velocity) << "Level " << level << ", particle " << i;
+				EXPECT_EQ(r.qom, p.qom) << "Level " << level << ", particle " << i;
+			}
+		}
+	}
+
+	FieldPushParameters getTestFieldParameters() {
+		FieldPushParameters params;
+		for(int i = 0; i < 2; i++) {
+			for(int j = 0; j < 2; j++) {
+				for(int k = 0; k < 2; k++) {
+					params.E[i][j][k] = { 0.01 * i, -0.02 * j, 0.03 + 0.01 * k };
+					params.B[i][j][k] = { 0.5 + i, 0.2 * j - 0.1 * k, 1.0 + 0.3 * i * k };
+				}
+			}
+		}
+		params.dt = 0.1;
+		return params;
+	}
+
+	template<typename T = particle_storage_type>
+	BasicParticleStore<T> createParticlesInCell(std::size_t num, std::uint32_t seed = 0) {
+		// place particles within the unit cell spanned by the corners of the field
+		return createRandomParticles<BasicParticleStore<T>>(num, Vector3<double>(0.0), Vector3<double>(1.0), seed);
+	}
+
+	TEST(BorisPusher, InterpolatedMatchesParticleUpdate) {
+
+		auto params = getTestFieldParameters();
+		auto particles = createParticlesInCell<double>(37);
+		auto reference = particles;
+
+		pushParticlesInInterpolatedField(particles, params, Level::Scalar);
+
+		for(std::size_t i = 0; i < reference.size(); i++) {
+			Particle p = reference[i];
+
+			// interpolate the field at the particle's position
+			Vector3<double> E = 0.0;
+			Vector3<double> B = 0.0;
+			for(int x = 0; x < 2; x++) {
+				for(int y = 0; y < 2; y++) {
+					for(int z = 0; z < 2; z++) {
+						auto fac = (x == 0 ? (1 - p.position.x) : p.position.x) * (y == 0 ? (1 - p.position.y) : p.position.y) * (z == 0 ? (1 - p.position.z) : p.position.z);
+						E += params.E[x][y][z] * fac;
+						B += params.B[x][y][z] * fac;
+					}
+				}
+			}
+
+			p.updateVelocity(E, B, params.dt);
+			p.updatePosition(params.dt);
+
+			// the results have to be bit-wise identical
+			Particle res = particles[i];
+			EXPECT_EQ(p.position, res.position) << "Particle " << i;
+			EXPECT_EQ(p.velocity, res.velocity) << "Particle " << i;
+		}
+
+		// and vectorized versions produce the same results
+		for(Level level : { Level::AVX2, Level::AVX512 }) {
+			if (utils::simd::getSupportedLevel() < level) continue;
+
+			for(std::size_t num : { 1, 5, 8, 17 }) {
+				auto scalar = createParticlesInCell(num, std::uint32_t(num));
+				auto vector = scalar;
+				pushParticlesInInterpolatedField(scalar, params, Level::Scalar);
+				pushParticlesInInterpolatedField(vector, params, level);
+
+				for(std::size_t i = 0; i < num; i++) {
+					Particle a = scalar[i];
+					Particle b = vector[i];
+					EXPECT_EQ(a.position, b.position) << "Level " << level << ", particle " << i << " of " << num;
+					EXPECT_EQ(a.velocity, b.velocity) << "Level " << level << ", particle " << i << " of " << num;
+				}
+			}
+		}
+	}
+
+	TEST(BorisPusher, SubCycling) {
+
+		// a particle close to the planet, requiring the maximum number of sub-cycles
+		Particle p;
+		p.position = { 0.0, 0.0, 1.0 };
+		p.velocity = { 1.0, 0.0, 0.0 };
+		p.q = p.qom = 1.0;
+
+		ParticleStore particles;
+		particles.push_back(p);
+
+		auto params = getTestParameters();
+		params.E = { 0.0, 0.0, 0.0 };
+		params.magneticFieldTemp = -1e6;
+
+		pushParticlesInDipoleField(particles, params);
+
+		// the particle is gyrating, preserving its speed
+		Particle res = particles.front();
+		EXPECT_NEAR(1.0, norm(res.velocity), 1e-12);
+		EXPECT_NE(p.velocity, res.velocity);
+	}
+
+}
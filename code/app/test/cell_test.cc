@@ -1,10 +1,15 @@
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <vector>
+
 #include "ipic3d/app/cell.h"
 #include "ipic3d/app/universe.h"
 
 #include "allscale/api/core/io.h"
 
+#include "random_particles.h"
+
 namespace ipic3d {
 
 	TEST(Cell, initCellsUniform) {
@@ -109,13 +114,28 @@ namespace ipic3d {
 
 		Cells&& cells = initCells(params, initProperties, universeProperties);
 
-		// verify the number of particles per cell
-		int particlesPerCell = initProperties.particlesPerCell[0].x * initProperties.particlesPerCell[0].y * initProperties.particlesPerCell[0].z;
+		// verify the number of particles per cell, covering all species
+		ASSERT_EQ(2, params.ns);
+		int particlesPerCell = 0;
+		for(const auto& cur : initProperties.particlesPerCell) {
+			particlesPerCell += cur.x * cur.y * cur.z;
+		}
 
 		utils::Coordinate<3> zero = 0;
 		allscale::api::user::algorithm::pfor(zero, universeProperties.size, [&](const utils::Coordinate<3>& pos) {
 			EXPECT_EQ(particlesPerCell, (int) cells[pos].particles.size());
 		});
+
+		// each species is initialized with its own charge over mass ratio, one species after the other
+		const auto& particles = cells[zero].particles;
+		ASSERT_EQ(2u, particles.getSpecies().size());
+		const unsigned electrons = initProperties.particlesPerCell[0].x * initProperties.particlesPerCell[0].y * initProperties.particlesPerCell[0].z;
+		for(std::size_t i = 0; i < particles.size(); i++) {
+			Particle p = particles[i];
+			const int s = (i < electrons) ? 0 : 1;
+			EXPECT_EQ(params.qom[s], p.qom) << "Particle " << i;
+			EXPECT_EQ(params.qom[s] < 0, p.q < 0) << "Particle " << i;
+		}
 	}
 
 
@@ -288,9 +308,320 @@ namespace ipic3d {
 		EXPECT_NEAR(Js.x, 1.0952, 1e-4);
 		EXPECT_NEAR(Js.y, 1.0952, 1e-4);
 		EXPECT_NEAR(Js.z, 1.0952, 1e-4);
+
+		// depositing the particles of each cell yields the same density
+		CurrentDensity density(size);
+		projectToDensityField(properties, universe.cells, density);
+		allscale::api::user::algorithm::pfor(zero, size, [&](const utils::Coordinate<3>& pos) {
+			EXPECT_NEAR(universe.currentDensity[pos].J.x, density[pos].J.x, 1e-12) << pos;
+			EXPECT_NEAR(universe.currentDensity[pos].J.y, density[pos].J.y, 1e-12) << pos;
+			EXPECT_NEAR(universe.currentDensity[pos].J.z, density[pos].J.z, 1e-12) << pos;
+		});
 	}
-		
-	
+
+	// invokes the given operation for universes of odd and degenerated sizes, filled with random particles of two species
+	template<typename Op>
+	void forRandomUniverses(const Op& op) {
+		for(const auto& size : { utils::Coordinate<3>{3,5,4}, utils::Coordinate<3>{1,2,3} }) {
+
+			UniverseProperties properties;
+			properties.size = size;
+			properties.cellWidth = { .5,.25,.75 };
+			properties.origin = { -1.0, 2.0, 0.5 };
+
+			Universe universe = Universe(properties);
+
+			// an odd number of particles per cell, such that the charges of the species do not cancel out
+			allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), size, [&](const utils::Coordinate<3>& pos) {
+				auto seed = std::uint32_t((pos.x * 17 + pos.y) * 17 + pos.z);
+				for(const auto& p : createRandomParticles<std::vector<Particle>>(11, getOriginOfCell(pos, properties), properties.cellWidth, seed)) {
+					universe.cells[pos].particles.push_back(p);
+				}
+			});
+
+			op(universe);
+		}
+	}
+
+	TEST(Cell, projectToDensityFieldByDeposition) {
+
+		// this test verifies that depositing particles reproduces the node-wise projection, also for odd and degenerated sizes
+
+		forRandomUniverses([](Universe& universe) {
+			const auto& properties = universe.properties;
+
+			auto densitySize = universe.currentDensity.size();
+			allscale::api::user::algorithm::pfor(utils::Coordinate<3>(0), densitySize, [&](const utils::Coordinate<3>& pos) {
+				projectToDensityField(properties, universe.cells, pos, universe.currentDensity);
+			});
+
+			// also with tiles of cells covering the universe partially
+			for(std::int64_t tileWidth : { 1, 2, 3, 8 }) {
+				CurrentDensity density(densitySize);
+				projectToDensityField(properties, universe.cells, density, tileWidth);
+
+				allscale::api::user::algorithm::pfor(utils::Coordinate<3>(0), densitySize, [&](const utils::Coordinate<3>& pos) {
+					const auto& expected = universe.currentDensity[pos].J;
+					const auto& actual = density[pos].J;
+					EXPECT_NEAR(expected.x, actual.x, 1e-12) << "Tile width " << tileWidth << " at " << pos;
+					EXPECT_NEAR(expected.y, actual.y, 1e-12) << "Tile width " << tileWidth << " at " << pos;
+					EXPECT_NEAR(expected.z, actual.z, 1e-12) << "Tile width " << tileWidth << " at " << pos;
+				});
+			}
+		});
+	}
+
+	TEST(Cell, projectToChargeDensity) {
+
+		// this test verifies the deposition of charges against a particle-wise projection, also for odd and degenerated sizes
+
+		forRandomUniverses([](Universe& universe) {
+			const auto& properties = universe.properties;
+			const auto& size = properties.size;
+
+			// the expected density on the distinct nodes of the periodic universe, using the relative positions of the particles
+			const double vol = properties.cellWidth.x * properties.cellWidth.y * properties.cellWidth.z;
+			allscale::api::user::data::Grid<double,3> expected(size);
+			allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), size, [&](const utils::Coordinate<3>& pos) {
+				expected[pos] = 0.0;
+			});
+			double totalCharge = 0.0;
+			allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), size, [&](const utils::Coordinate<3>& pos) {
+				const auto& particles = universe.cells[pos].particles;
+				const auto* px = particles.data(ParticleStore::X);
+				const auto* py = particles.data(ParticleStore::Y);
+				const auto* pz = particles.data(ParticleStore::Z);
+				for(std::size_t n = 0; n < particles.size(); n++) {
+					const double q = particles.getSpecies()[particles.getSpeciesIds()[n]].q;
+					totalCharge += q;
+					for(int i = 0; i < 2; i++) {
+						for(int j = 0; j < 2; j++) {
+							for(int k = 0; k < 2; k++) {
+								const double w = (i ? px[n] : 1 - px[n]) * (j ? py[n] : 1 - py[n]) * (k ? pz[n] : 1 - pz[n]);
+								const utils::Coordinate<3> node { (pos.x + i) % size.x, (pos.y + j) % size.y, (pos.z + k) % size.z };
+								expected[node] += q * w / (8.0 * vol);
+							}
+						}
+					}
+				}
+			});
+			ASSERT_NE(0.0, totalCharge);
+
+			ChargeDensity density = initChargeDensity(properties);
+			ASSERT_EQ(universe.currentDensity.size(), density.size());
+			projectToChargeDensity(properties, universe.cells, density);
+
+			// nodes on opposite boundaries coincide
+			double sum = 0.0;
+			allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), density.size(), [&](const utils::Coordinate<3>& pos) {
+				const utils::Coordinate<3> node { pos.x % size.x, pos.y % size.y, pos.z % size.z };
+				EXPECT_NEAR(expected[node], density[pos].rho, 1e-12) << pos;
+				if (pos.strictlyDominatedBy(size)) sum += density[pos].rho;
+			});
+
+			// the charge is conserved
+			EXPECT_NEAR(totalCharge, sum * 8.0 * vol, 1e-10);
+		});
+	}
+
+	TEST(Cell, ParticleMigration) {
+
+		// this test checks the transfer of particles between neighboring cells
+
+		UniverseProperties properties;
+		properties.size = { 3,3,3 };
+		properties.cellWidth = { .5,.5,.5 };
+
+		Universe universe = Universe(properties);
+		TransferBuffers transfers(properties.size);
+
+		Cell& a = universe.cells[{1,1,1}];
+		Cell& b = universe.cells[{2,1,0}];
+
+		// a particle which left cell a towards b
+		Particle p;
+		p.position = { 1.1, 0.7, 0.4 };
+		p.q = p.qom = 1.0;
+		a.particles.push_back(p);
+
+		// and one staying in a
+		p.position = { 0.6, 0.7, 0.8 };
+		a.particles.push_back(p);
+
+		exportParticles(properties, a, {1,1,1}, transfers);
+		ASSERT_EQ(1, a.particles.size());
+		EXPECT_EQ(0.6, Particle(a.particles.front()).position.x);
+
+		// the particle is sent from a towards b
+		auto& buffer = transfers.getBuffer({1,1,1});
+		EXPECT_EQ(1, buffer.size());
+		EXPECT_EQ(1, buffer.size(TransferDirection(2,1,0)));
+
+		// importing the particle leaves the buffer untouched
+		importParticles(properties, b, {2,1,0}, transfers);
+		EXPECT_EQ(1, buffer.size());
+		ASSERT_EQ(1, b.particles.size());
+
+		Particle res = b.particles.front();
+		EXPECT_NEAR(1.1, res.position.x, 1e-12);
+		EXPECT_NEAR(0.7, res.position.y, 1e-12);
+		EXPECT_NEAR(0.4, res.position.z, 1e-12);
+		EXPECT_TRUE(verifyCorrectParticlesPositionInCell(properties, b, {2,1,0}));
+
+		// the next export re-fills the buffer
+		exportParticles(properties, a, {1,1,1}, transfers);
+		EXPECT_TRUE(buffer.empty());
+		EXPECT_EQ(1, a.particles.size());
+	}
+
+	TEST(Cell, KineticEnergyAfterMigration) {
+
+		// this test checks that migrating particles retains a valid kinetic energy of the receiving cells
+
+		UniverseProperties properties;
+		properties.size = { 3,3,3 };
+		properties.cellWidth = { .5,.5,.5 };
+
+		Universe universe = Universe(properties);
+		TransferBuffers transfers(properties.size);
+
+		Cell& a = universe.cells[{1,1,1}];
+		Cell& b = universe.cells[{2,1,1}];
+
+		// two particles of different species leaving a towards b
+		Particle p;
+		p.position = { 1.1, 0.7, 0.6 };
+		p.velocity = { 1.0, 2.0, 0.0 };
+		p.q = 1.0;
+		p.qom = 0.5;
+		a.particles.push_back(p);
+		p.velocity = { 0.0, 0.0, 3.0 };
+		p.q = -1.0;
+		p.qom = -25.0;
+		a.particles.push_back(p);
+
+		exportParticles(properties, a, {1,1,1}, transfers);
+		importParticles(properties, b, {2,1,1}, transfers);
+		ASSERT_EQ(2, b.particles.size());
+		EXPECT_TRUE(a.particles.empty());
+
+		// only the species of the migrated particles are known to b
+		EXPECT_EQ(2, b.particles.getSpecies().size());
+		EXPECT_EQ(0.5 * 2.0 * 5.0 + 0.5 * 0.04 * 9.0, getParticlesKineticEnergy(b));
+		EXPECT_EQ(0.0, getParticlesKineticEnergy(a));
+	}
+
+	TEST(Cell, PlanetAbsorption) {
+
+		// this test checks that particles entering the planet are removed, no matter the cell they are leaving
+
+		UniverseProperties properties;
+		properties.size = { 4,4,4 };
+		properties.cellWidth = { .5,.5,.5 };
+		properties.objectCenter = { 1.0, 1.0, 1.0 };
+		properties.planetRadius = 0.3;
+
+		// only the cells touching the center of the universe intersect the planet
+		EXPECT_TRUE(intersectsPlanet({1,1,1}, properties));
+		EXPECT_TRUE(intersectsPlanet({2,2,2}, properties));
+		EXPECT_TRUE(intersectsPlanet({1,2,1}, properties));
+		EXPECT_FALSE(intersectsPlanet({0,1,1}, properties));
+		EXPECT_FALSE(intersectsPlanet({3,3,3}, properties));
+
+		// also cells touching the planet from the outside are considered intersecting
+		properties.planetRadius = 0.5;
+		EXPECT_TRUE(intersectsPlanet({0,1,1}, properties));
+		EXPECT_FALSE(intersectsPlanet({0,0,1}, properties));
+		properties.planetRadius = 0.3;
+
+		Universe universe = Universe(properties);
+		TransferBuffers transfers(properties.size);
+
+		// a particle entering the planet from a cell not intersecting it
+		Cell& a = universe.cells[{0,1,1}];
+		Particle p;
+		p.position = { 0.9, 0.9, 0.9 };
+		p.q = p.qom = 1.0;
+		a.particles.push_back(p);
+
+		// and one staying in that cell
+		p.position = { 0.4, 0.9, 0.9 };
+		a.particles.push_back(p);
+
+		exportParticles(properties, a, {0,1,1}, transfers);
+		ASSERT_EQ(1, a.particles.size());
+		EXPECT_NEAR(0.4, Particle(a.particles.front()).position.x, 1e-12);
+		EXPECT_TRUE(transfers.getBuffer({0,1,1}).empty());
+
+		// a particle inside the planet in a cell intersecting it
+		Cell& b = universe.cells[{1,1,1}];
+		p.position = { 0.9, 0.9, 0.9 };
+		b.particles.push_back(p);
+
+		// and one outside
+		p.position = { 0.6, 0.6, 0.6 };
+		b.particles.push_back(p);
+
+		exportParticles(properties, b, {1,1,1}, transfers);
+		ASSERT_EQ(1, b.particles.size());
+		EXPECT_NEAR(0.6, Particle(b.particles.front()).position.x, 1e-12);
+	}
+
+	TEST(Cell, ParticleMigrationWithinTile) {
+
+		// this test checks that particles moving within a tile are directly handed over to their new cell
+
+		UniverseProperties properties;
+		properties.size = { 4,4,4 };
+		properties.cellWidth = { .5,.5,.5 };
+
+		Universe universe = Universe(properties);
+		TransferBuffers transfers(properties.size);
+
+		// the tile [0,2)^3
+		utils::Coordinate<3> tileBegin = 0;
+		utils::Coordinate<3> tileEnd = 2;
+
+		Cell& a = universe.cells[{1,1,1}];
+		Cell& b = universe.cells[{0,1,1}];
+
+		// a particle moving to b, within the tile
+		Particle p;
+		p.position = { 0.4, 0.7, 0.8 };
+		p.q = p.qom = 1.0;
+		a.particles.push_back(p);
+
+		// one leaving the tile
+		p.position = { 1.1, 0.7, 0.8 };
+		a.particles.push_back(p);
+
+		// and one staying in a
+		p.position = { 0.6, 0.7, 0.8 };
+		a.particles.push_back(p);
+
+		exportParticles(properties, universe.cells, {1,1,1}, tileBegin, tileEnd, transfers);
+		ASSERT_EQ(1, a.particles.size());
+		EXPECT_EQ(0.6, Particle(a.particles.front()).position.x);
+
+		// only the particle leaving the tile passes through the buffer
+		auto& buffer = transfers.getBuffer({1,1,1});
+		EXPECT_EQ(1, buffer.size());
+		EXPECT_EQ(1, buffer.size(TransferDirection(2,1,1)));
+
+		// the other one got appended to b
+		ASSERT_EQ(1, b.particles.size());
+		Particle res = b.particles.front();
+		EXPECT_NEAR(0.4, res.position.x, 1e-12);
+		EXPECT_NEAR(0.7, res.position.y, 1e-12);
+		EXPECT_NEAR(0.8, res.position.z, 1e-12);
+		EXPECT_TRUE(verifyCorrectParticlesPositionInCell(properties, b, {0,1,1}));
+
+		// and is retained by the export of b
+		exportParticles(properties, universe.cells, {0,1,1}, tileBegin, tileEnd, transfers);
+		EXPECT_EQ(1, b.particles.size());
+		EXPECT_TRUE(transfers.getBuffer({0,1,1}).empty());
+	}
+
 	TEST(Cell, TestCellOutput) {
 
 		// this test checks the output of the number of particles per cell
@@ -371,8 +702,4 @@ namespace ipic3d {
 
 	}
 
-	TEST(Cell, DISABLED_DensityContributions) {
-		// TODO: implement test for density contribution computation
-	}
-
 }
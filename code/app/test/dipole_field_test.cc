@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+#include "ipic3d/app/dipole_field.h"
+
+namespace ipic3d {
+
+	using utils::simd::Level;
+
+	// the reference formula of the dipole field, based on pow()
+	Vector3<double> getReferenceField(const Vector3<double>& B0, double R, const Vector3<double>& pos) {
+		double fac1 = -B0.z * pow(R, 3) / pow(allscale::utils::sumOfSquares(pos), 2.5);
+		Vector3<double> B;
+		B.x = 3.0 * pos.x * pos.z * fac1;
+		B.y = 3.0 * pos.y * pos.z * fac1;
+		B.z = (2.0 * pow(pos.z, 2) - pow(pos.x, 2) - pow(pos.y, 2)) * fac1;
+		return B;
+	}
+
+	TEST(DipoleField, InverseSqrt) {
+		for(double x : { 1e-300, 1e-20, 0.25, 1.0, 2.0, 3.0, 1e3, 7.5e12, 1e300 }) {
+			double res;
+			utils::simd::inverseSqrt(res, x);
+			EXPECT_NEAR(1.0, res * std::sqrt(x), 1e-15) << "x = " << x;
+		}
+	}
+
+	TEST(DipoleField, Accuracy) {
+
+		Vector3<double> B0 = { 0.0, 0.0, 0.01 };
+		double R = 0.2;
+		DipoleField field(B0, R);
+
+		EXPECT_NEAR(-B0.z * pow(R, 3), field.getFactor(), 1e-18);
+
+		// compare with the reference formula over a wide range of distances
+		std::minstd_rand rand(3);
+		std::uniform_real_distribution<> dir(-1.0, 1.0);
+		std::uniform_real_distribution<> exponent(-2.0, 4.0);
+		for(int i = 0; i < 10000; i++) {
+			Vector3<double> pos = { dir(rand), dir(rand), dir(rand) };
+			pos = pos * pow(10.0, exponent(rand));
+
+			auto ref = getReferenceField(B0, R, pos);
+			auto res = field(pos);
+			EXPECT_LT(norm(ref - res), 1e-13 * norm(ref)) << "Position " << pos;
+		}
+	}
+
+	TEST(DipoleField, Vectorized) {
+
+		DipoleField field(-2.5);
+
+		#ifdef IPIC3D_X86_SIMD
+
+			// all lanes agree bit-wise with the scalar evaluation
+			utils::simd::double8 x, y, z, Bx, By, Bz;
+			double xs[8], ys[8], zs[8];
+			for(int i = 0; i < 8; i++) {
+				xs[i] = 0.5 + i;
+				ys[i] = -1.0 + 0.3 * i;
+				zs[i] = 2.0 - 0.7 * i;
+			}
+			utils::simd::load(x, xs);
+			utils::simd::load(y, ys);
+			utils::simd::load(z, zs);
+			field.evaluate(x, y, z, Bx, By, Bz);
+
+			double bx[8], by[8], bz[8];
+			utils::simd::store(bx, Bx);
+			utils::simd::store(by, By);
+			utils::simd::store(bz, Bz);
+			for(int i = 0; i < 8; i++) {
+				auto ref = field({ xs[i], ys[i], zs[i] });
+				EXPECT_EQ(ref.x, bx[i]) << "Lane " << i;
+				EXPECT_EQ(ref.y, by[i]) << "Lane " << i;
+				EXPECT_EQ(ref.z, bz[i]) << "Lane " << i;
+			}
+
+		#endif
+	}
+
+}
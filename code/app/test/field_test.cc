@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <random>
+
 #include "ipic3d/app/cell.h"
 #include "ipic3d/app/universe.h"
 
@@ -376,15 +378,15 @@ namespace ipic3d {
 		auto fSize = field.size() - coordinate_type{1,1,1};
 		auto bcSize = bcfield.size()- coordinate_type{ 1, 1, 1 };
 
-		// make sure corners were not written
+		// make sure corners were written with the opposite corners of the interior
 		for(int i = 0; i < 2; ++i) {
 			for(int j = 0; j < 2; ++j) {
 				for(int k = 0; k < 2; ++k) {
 					auto fPos = coordinate_type{ i * fSize.x, j * fSize.y, k * fSize.z };
 					auto bcPos = coordinate_type{ i * bcSize.x, j * bcSize.y, k * bcSize.z };
-					EXPECT_EQ(Vector3<double>((double)fPos.x, (double)fPos.y, (double)fPos.z), field[fPos].E) << " at " << fPos;
-					EXPECT_EQ(Vector3<double>((double)fPos.x, (double)fPos.y, (double)fPos.z), field[fPos].B) << " at " << fPos;
-					EXPECT_EQ(Vector3<double>((double)bcPos.x, (double)bcPos.y, (double)bcPos.z), bcfield[bcPos].Bc) << " at " << bcPos;
+					EXPECT_EQ(Vector3<double>(1.0), field[fPos].E) << " at " << fPos;
+					EXPECT_EQ(Vector3<double>(2.0), field[fPos].B) << " at " << fPos;
+					EXPECT_EQ(Vector3<double>(3.0), bcfield[bcPos].Bc) << " at " << bcPos;
 				}
 			}
 		}
@@ -556,6 +558,377 @@ namespace ipic3d {
 		EXPECT_NEAR( B.z, 0.0, 1e-15 );
 	}
 
-} // end namespace ipic3d
+	// initializes the given grids with the same random values on each call
+	void fillRandomly(Field& field, BcField& bcfield, CurrentDensity& density) {
+		std::minstd_rand rand(0);
+		std::uniform_real_distribution<> value(-1.0, 1.0);
+		auto random = [&]() { return Vector3<double>{ value(rand), value(rand), value(rand) }; };
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(0), field.size(), [&](const auto& pos) {
+			field[pos].E = random();
+			field[pos].B = random();
+		});
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(0), bcfield.size(), [&](const auto& pos) {
+			bcfield[pos].Bc = random();
+		});
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(0), density.size(), [&](const auto& pos) {
+			density[pos].J = random();
+		});
+	}
+
+	// checks that the leapfrog solver advancing the given number of steps at once in tiles of various widths
+	// reproduces the node-wise one bitwise
+	void checkBlockedLeapfrog(const UniverseProperties& properties, unsigned numSteps) {
+
+		Field initialField(properties.size + coordinate_type(3));
+		BcField initialBcField(properties.size + coordinate_type(2));
+		CurrentDensity density(properties.size + coordinate_type(1));
+		fillRandomly(initialField, initialBcField, density);
+
+		// the reference: updating the inner nodes one after the other, for the given number of steps
+		Field refField(initialField.size());
+		BcField refBcField(initialBcField.size());
+		fillRandomly(refField, refBcField, density);
+		for(unsigned i = 0; i < numSteps; ++i) {
+			allscale::api::user::algorithm::detail::forEach(coordinate_type(1), refField.size() - coordinate_type(1), [&](const auto& pos) {
+				solveFieldLeapfrog(properties, pos, density, refField, refBcField);
+			});
+		}
+
+		// tiles narrower than the number of steps vanish at the lower boundary
+		for(std::int64_t tileWidth : { 1, 2, 3, 8, 16 }) {
+			Field field(initialField.size());
+			BcField bcfield(initialBcField.size());
+			fillRandomly(field, bcfield, density);
+			solveFieldLeapfrogSteps(properties, density, field, bcfield, numSteps, tileWidth);
+
+			allscale::api::user::algorithm::detail::forEach(coordinate_type(0), field.size(), [&](const auto& pos) {
+				EXPECT_EQ(refField[pos].E, field[pos].E) << numSteps << " steps, tile width " << tileWidth << " at " << pos;
+				EXPECT_EQ(refField[pos].B, field[pos].B) << numSteps << " steps, tile width " << tileWidth << " at " << pos;
+			});
+			allscale::api::user::algorithm::detail::forEach(coordinate_type(0), bcfield.size(), [&](const auto& pos) {
+				EXPECT_EQ(refBcField[pos].Bc, bcfield[pos].Bc) << numSteps << " steps, tile width " << tileWidth << " at " << pos;
+			});
+		}
 
+		// the fields got actually updated
+		EXPECT_NE(initialField[coordinate_type(2)].E, refField[coordinate_type(2)].E);
+		EXPECT_NE(initialBcField[coordinate_type(2)].Bc, refBcField[coordinate_type(2)].Bc);
+	}
+
+	TEST(Field, solveFieldLeapfrogBlocked) {
+
+		// this test verifies that a single step of the blocked leapfrog solver reproduces the node-wise one bitwise
+
+		UniverseProperties properties;
+		properties.size = { 6,9,5 };
+		properties.cellWidth = { 0.5,0.25,0.75 };
+		properties.dt = 0.1;
+		properties.speedOfLight = 0.7;
+		properties.useCase = UseCase::Dipole;
 
+		checkBlockedLeapfrog(properties, 1);
+	}
+
+	TEST(Field, solveFieldLeapfrogTemporallyBlocked) {
+
+		// this test verifies that the temporally blocked leapfrog solver reproduces the node-wise one bitwise
+
+		UniverseProperties properties;
+		properties.size = { 11,7,4 };
+		properties.cellWidth = { 0.5,0.25,0.75 };
+		properties.dt = 0.1;
+		properties.speedOfLight = 0.7;
+		properties.useCase = UseCase::Dipole;
+
+		for(unsigned numSteps : { 2, 5 }) {
+			checkBlockedLeapfrog(properties, numSteps);
+		}
+	}
+
+	TEST(Field, solveFieldImplicitMaxwell) {
+
+		// the implicit Maxwell solver remains stable for time steps far beyond the light-speed limit of the explicit ones
+
+		UniverseProperties properties;
+		properties.size = { 8,8,8 };
+		properties.cellWidth = { 0.5,0.5,0.5 };
+		properties.dt = 5.0;
+		properties.speedOfLight = 1.0;
+		properties.useCase = UseCase::Dipole;
+		properties.GMREStol = 1e-8;
+
+		// random fields without sources
+		Field field(properties.size + coordinate_type(3));
+		BcField bcfield(properties.size + coordinate_type(2));
+		CurrentDensity density(properties.size + coordinate_type(1));
+		fillRandomly(field, bcfield, density);
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(0), field.size(), [&](const auto& pos) {
+			field[pos].Bext = Vector3<double>(1.0);
+		});
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(0), density.size(), [&](const auto& pos) {
+			density[pos].J = Vector3<double>(0.0);
+		});
+
+		// the energy of the distinct nodes and centers
+		auto getEnergy = [&]() {
+			double res = 0.0;
+			allscale::api::user::algorithm::detail::forEach(coordinate_type(1), properties.size + coordinate_type(1), [&](const auto& pos) {
+				res += allscale::utils::sumOfSquares(field[pos].E);
+			});
+			allscale::api::user::algorithm::detail::forEach(coordinate_type(1), bcfield.size() - coordinate_type(1), [&](const auto& pos) {
+				res += allscale::utils::sumOfSquares(bcfield[pos].Bc);
+			});
+			return res;
+		};
+
+		// without sources, the backward Euler scheme (theta = 1) dissipates energy
+		double energy = getEnergy();
+		for(int i = 0; i < 5; ++i) {
+			auto stats = solveFieldImplicitMaxwell(properties, density, field, bcfield);
+			EXPECT_TRUE(stats.converged) << "Step " << i << ", residual " << stats.residual;
+			EXPECT_LE(stats.residual, properties.GMREStol);
+
+			double next = getEnergy();
+			EXPECT_LT(next, energy) << "Step " << i;
+			energy = next;
+		}
+
+		// nodes and centers are periodic, B is interpolated to the nodes and the external field is retained
+		const auto n = properties.size;
+		EXPECT_EQ((field[{ 1, 2, 3 }].E), (field[{ n.x + 1, 2, 3 }].E));
+		EXPECT_EQ((field[{ 2, 1, 3 }].E), (field[{ 2, n.y + 1, 3 }].E));
+		EXPECT_EQ((field[{ 2, 3, 2 }].E), (field[{ 2, 3, n.z + 2 }].E));
+		EXPECT_EQ((field[{ n.x, 2, 3 }].E), (field[{ 0, 2, 3 }].E));
+		EXPECT_EQ(bcfield[coordinate_type(1)].Bc, (bcfield[bcfield.size() - coordinate_type(1)].Bc));
+		Vector3<double> B(0.0);
+		for(int i = 0; i < 2; i++) {
+			for(int j = 0; j < 2; j++) {
+				for(int k = 0; k < 2; k++) {
+					B += bcfield[coordinate_type{ 3 - i, 3 - j, 3 - k }].Bc;
+				}
+			}
+		}
+		EXPECT_EQ(.125 * B, field[coordinate_type(3)].B);
+		EXPECT_EQ(Vector3<double>(1.0), field[coordinate_type(3)].Bext);
+
+		// in contrast, the explicit solver diverges for this time step
+		double explicitEnergy = getEnergy();
+		for(int i = 0; i < 5; ++i) {
+			solveFieldLeapfrog(properties, density, field, bcfield);
+			updateFieldsOnBoundaries(field, bcfield);
+		}
+		EXPECT_GT(getEnergy(), 1e3 * explicitEnergy);
+	}
+
+	TEST(Field, solveFieldImplicitMaxwellSmallTimeStep) {
+
+		// for small time steps, the change of E approaches the explicit time derivative
+
+		UniverseProperties properties;
+		properties.size = { 6,5,4 };
+		properties.cellWidth = { 1.0,0.5,0.75 };
+		properties.dt = 1e-4;
+		properties.speedOfLight = 0.8;
+		properties.useCase = UseCase::Dipole;
+		properties.theta = 0.5;
+		properties.GMREStol = 1e-12;
+
+		Field field(properties.size + coordinate_type(3));
+		BcField bcfield(properties.size + coordinate_type(2));
+		CurrentDensity density(properties.size + coordinate_type(1));
+		fillRandomly(field, bcfield, density);
+		updateFieldsOnBoundaries(field, bcfield);
+
+		// the explicit time derivative dE/dt = c^2 * curl(B) - J on the distinct nodes
+		Field derivative(field.size());
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(1), properties.size + coordinate_type(1), [&](const auto& pos) {
+			Vector3<double> curl;
+			computeCurlB(properties, pos, bcfield, curl);
+			derivative[pos].E = properties.speedOfLight * properties.speedOfLight * curl - density[pos - coordinate_type(1)].J;
+			derivative[pos].B = field[pos].E;
+		});
+
+		auto stats = solveFieldImplicitMaxwell(properties, density, field, bcfield);
+		EXPECT_TRUE(stats.converged) << stats.residual;
+
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(1), properties.size + coordinate_type(1), [&](const auto& pos) {
+			auto change = (field[pos].E - derivative[pos].B) * (1.0 / properties.dt);
+			EXPECT_LT(norm(change - derivative[pos].E), 1e-3 * (1.0 + norm(derivative[pos].E))) << pos;
+		});
+	}
+
+	TEST(Field, correctElectricField) {
+
+		// the divergence cleaning enforces Gauss's law for the discrete divergence, changing E by a gradient only
+
+		UniverseProperties properties;
+		properties.size = { 8,8,8 };
+		properties.cellWidth = { 0.5,0.4,0.6 };
+		properties.useCase = UseCase::Dipole;
+		properties.CGtol = 1e-10;
+
+		std::minstd_rand rand(0);
+		std::uniform_real_distribution<> value(-1.0, 1.0);
+
+		Field field(properties.size + coordinate_type(3));
+		ChargeDensity density = initChargeDensity(properties);
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(0), field.size(), [&](const auto& pos) {
+			field[pos].E = { value(rand), value(rand), value(rand) };
+			field[pos].B = { value(rand), value(rand), value(rand) };
+			field[pos].Bext = Vector3<double>(1.0);
+		});
+
+		// a charge density, whose nodes on opposite boundaries coincide, with a non-zero mean
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(0), density.size(), [&](const auto& pos) {
+			const coordinate_type node { pos.x % properties.size.x, pos.y % properties.size.y, pos.z % properties.size.z };
+			density[pos].rho = 0.5 + std::sin(node.x + 2.0 * node.y) * std::cos(node.z);
+		});
+
+		// the distinct nodes [1,N+1) and their periodic images
+		const auto period = properties.size;
+		auto image = [&](const coordinate_type& pos) {
+			coordinate_type res;
+			for(int d = 0; d < 3; ++d) {
+				res[d] = (pos[d] + period[d] - 1) % period[d] + 1;
+			}
+			return res;
+		};
+
+		// the backward difference divergence of E minus rho, whose mean is not constrained
+		ScalarField error(period);
+		auto computeError = [&]() {
+			double mean = 0.0;
+			allscale::api::user::algorithm::detail::forEach(coordinate_type(1), period + coordinate_type(1), [&](const auto& pos) {
+				double div = 0.0;
+				for(int d = 0; d < 3; ++d) {
+					auto lower = pos;
+					lower[d]--;
+					div += (field[pos].E[d] - field[image(lower)].E[d]) / properties.cellWidth[d];
+				}
+				error[pos - coordinate_type(1)] = div - density[pos - coordinate_type(1)].rho;
+				mean += error[pos - coordinate_type(1)];
+			});
+			mean /= double(period.x * period.y * period.z);
+			double res = 0.0;
+			allscale::api::user::algorithm::detail::forEach(coordinate_type(0), period, [&](const auto& pos) {
+				res = std::max(res, std::abs(error[pos] - mean));
+			});
+			return res;
+		};
+
+		const double before = computeError();
+		EXPECT_LT(1.0, before);
+
+		Field original(field.size());
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(0), field.size(), [&](const auto& pos) {
+			original[pos] = field[pos];
+		});
+
+		PoissonSolver solver(properties.size, properties.cellWidth);
+		auto stats = correctElectricField(properties, density, field, solver);
+		EXPECT_TRUE(stats.converged);
+		EXPECT_LT(0u, stats.iterations);
+		EXPECT_GT(1e-8, computeError());
+
+		// E changed by the forward difference gradient of some potential, thus its discrete curl is unchanged
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(1), period + coordinate_type(1), [&](const auto& pos) {
+			auto diff = [&](const coordinate_type& p) { return field[image(p)].E - original[image(p)].E; };
+			for(int d = 0; d < 3; ++d) {
+				const int e = (d + 1) % 3;
+				auto next = [](coordinate_type p, int dim) { p[dim]++; return p; };
+				const double curl = (diff(next(pos, d))[e] - diff(pos)[e]) / properties.cellWidth[d] - (diff(next(pos, e))[d] - diff(pos)[d]) / properties.cellWidth[e];
+				EXPECT_NEAR(0.0, curl, 1e-8) << pos << " " << d;
+			}
+		});
+
+		// the remaining nodes are periodic images, and B is not affected
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(0), field.size(), [&](const auto& pos) {
+			EXPECT_EQ(field[image(pos)].E, field[pos].E) << pos;
+			EXPECT_EQ(original[pos].B, field[pos].B) << pos;
+			EXPECT_EQ(original[pos].Bext, field[pos].Bext) << pos;
+		});
+
+		// a field obeying Gauss's law is changed by rounding errors only
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(0), field.size(), [&](const auto& pos) {
+			original[pos] = field[pos];
+		});
+		correctElectricField(properties, density, field, solver);
+		EXPECT_GT(1e-8, computeError());
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(0), field.size(), [&](const auto& pos) {
+			EXPECT_GT(1e-8, allscale::utils::sumOfSquares(field[pos].E - original[pos].E)) << pos;
+		});
+	}
+
+	TEST(Field, VectorFieldKernels) {
+
+		// this test verifies that the kernels on vector fields reproduce the node-wise functions bitwise
+
+		using utils::simd::Level;
+
+		UniverseProperties properties;
+		properties.size = { 5,4,13 };
+		properties.cellWidth = { 0.5,0.25,0.75 };
+
+		std::minstd_rand rand(0);
+		std::uniform_real_distribution<> value(-1.0, 1.0);
+		auto random = [&]() { return Vector3<double>{ value(rand), value(rand), value(rand) }; };
+
+		Field field(properties.size + coordinate_type(3));
+		BcField bcfield(properties.size + coordinate_type(2));
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(0), field.size(), [&](const auto& pos) {
+			field[pos].E = random();
+			field[pos].B = random();
+		});
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(0), bcfield.size(), [&](const auto& pos) {
+			bcfield[pos].Bc = random();
+		});
+
+		VectorField E(field.size());
+		VectorField B(field.size());
+		VectorField Bc(bcfield.size());
+		loadVectorField(field, &FieldNode::E, E);
+		loadVectorField(field, &FieldNode::B, B);
+		loadVectorField(bcfield, &BcFieldCell::Bc, Bc);
+
+		for(Level level : { Level::Scalar, Level::AVX2, Level::AVX512 }) {
+			if (utils::simd::getSupportedLevel() < level) continue;
+
+			// kernels reading the upper corners cover the entire result
+			VectorField curlE(bcfield.size());
+			VectorField centers(bcfield.size());
+			computeCurlE(properties, E, curlE, level);
+			interpN2C(B, centers, level);
+			BcField refCenters(bcfield.size());
+			allscale::api::user::algorithm::detail::forEach(coordinate_type(0), bcfield.size(), [&](const auto& pos) {
+				Vector3<double> curl;
+				computeCurlE(properties, pos, field, curl);
+				EXPECT_EQ(curl, curlE[pos]) << "Level " << level << " at " << pos;
+
+				interpN2C(pos, field, refCenters);
+				EXPECT_EQ(refCenters[pos].Bc, centers[pos]) << "Level " << level << " at " << pos;
+			});
+
+			// kernels reading the lower corners leave the boundary untouched
+			VectorField curlB(field.size());
+			VectorField nodes(field.size());
+			computeCurlB(properties, Bc, curlB, level);
+			interpC2N(Bc, nodes, level);
+			Field refNodes(field.size());
+			allscale::api::user::algorithm::detail::forEach(coordinate_type(0), curlB.size(), [&](const auto& pos) {
+				if (!(coordinate_type(0).strictlyDominatedBy(pos) && pos.strictlyDominatedBy(curlB.size() - coordinate_type(1)))) {
+					EXPECT_EQ(Vector3<double>(0.0), curlB[pos]) << "Level " << level << " at " << pos;
+					EXPECT_EQ(Vector3<double>(0.0), nodes[pos]) << "Level " << level << " at " << pos;
+					return;
+				}
+
+				Vector3<double> curl;
+				computeCurlB(properties, pos, bcfield, curl);
+				EXPECT_EQ(curl, curlB[pos]) << "Level " << level << " at " << pos;
+
+				interpC2N(pos, bcfield, refNodes);
+				EXPECT_EQ(refNodes[pos].B, nodes[pos]) << "Level " << level << " at " << pos;
+			});
+		}
+	}
+
+} // end namespace ipic3d
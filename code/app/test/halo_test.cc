@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <set>
+
+#include "ipic3d/app/halo.h"
+#include "ipic3d/app/vector.h"
+
+namespace ipic3d {
+
+	using coordinate_type = utils::Coordinate<3>;
+
+	TEST(Halo, Regions) {
+
+		coordinate_type size = { 5,4,7 };
+		auto regions = getHaloRegions(size);
+		EXPECT_EQ(26u, regions.size());
+
+		// the regions cover the ghost layer exactly once
+		std::set<unsigned> directions;
+		allscale::api::user::data::Grid<int,3> coverage(size);
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(0), size, [&](const auto& pos) {
+			coverage[pos] = 0;
+		});
+		for(const auto& region : regions) {
+			EXPECT_TRUE(directions.insert(region.direction.getIndex()).second);
+			allscale::api::user::algorithm::detail::forEach(region.begin, region.end, [&](const auto& pos) {
+				coverage[pos]++;
+
+				// the source is part of the interior
+				auto source = pos + region.offset;
+				EXPECT_TRUE(coordinate_type(0).strictlyDominatedBy(source)) << pos << " -> " << source;
+				EXPECT_TRUE(source.strictlyDominatedBy(size - coordinate_type(1))) << pos << " -> " << source;
+			});
+		}
+		EXPECT_EQ(0u, directions.count(TransferDirection(1, 1, 1).getIndex()));
+
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(0), size, [&](const auto& pos) {
+			bool interior = coordinate_type(0).strictlyDominatedBy(pos) && pos.strictlyDominatedBy(size - coordinate_type(1));
+			EXPECT_EQ(interior ? 0 : 1, coverage[pos]) << pos;
+		});
+	}
+
+	TEST(Halo, PeriodicUpdate) {
+
+		struct Element {
+			Vector3<double> value;
+			double constant;
+		};
+
+		// a grid of different extents in each dimension
+		coordinate_type size = { 6,3,9 };
+		allscale::api::user::data::Grid<Element,3> grid(size);
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(0), size, [&](const auto& pos) {
+			grid[pos].value = { (double)pos.x, (double)pos.y, (double)pos.z };
+			grid[pos].constant = -1.0;
+		});
+
+		updatePeriodicHalo(grid, [](Element& ghost, const Element& source) {
+			ghost.value = source.value;
+		});
+
+		allscale::api::user::algorithm::detail::forEach(coordinate_type(0), size, [&](const auto& pos) {
+			// the periodic image of the position within the interior
+			coordinate_type image = pos;
+			for(int d = 0; d < 3; ++d) {
+				if (pos[d] == 0) image[d] = size[d] - 2;
+				if (pos[d] == size[d] - 1) image[d] = 1;
+			}
+			EXPECT_EQ((Vector3<double>{ (double)image.x, (double)image.y, (double)image.z }), grid[pos].value) << pos;
+
+			// only the selected components got copied
+			EXPECT_EQ(-1.0, grid[pos].constant) << pos;
+		});
+	}
+
+} // end namespace ipic3d
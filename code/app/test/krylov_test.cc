@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "ipic3d/app/utils/krylov.h"
+
+namespace ipic3d {
+namespace utils {
+
+	namespace {
+
+		// a minimal vector type providing the operations required by the solvers
+		struct TestVector {
+			std::vector<double> values;
+		};
+
+		double dotProduct(const TestVector& a, const TestVector& b) {
+			double res = 0.0;
+			for(std::size_t i = 0; i < a.values.size(); ++i) {
+				res += a.values[i] * b.values[i];
+			}
+			return res;
+		}
+
+		void addScaled(TestVector& y, double factor, const TestVector& x) {
+			for(std::size_t i = 0; i < y.values.size(); ++i) {
+				y.values[i] += factor * x.values[i];
+			}
+		}
+
+		void scale(TestVector& x, double factor) {
+			for(auto& cur : x.values) {
+				cur *= factor;
+			}
+		}
+
+		// a symmetric, diagonally dominant tridiagonal matrix with periodic wrap-around
+		struct TestOperator {
+			int n;
+			void operator()(const TestVector& x, TestVector& y) const {
+				for(int i = 0; i < n; ++i) {
+					y.values[i] = (4.0 + 0.1 * i) * x.values[i] - 1.5 * (x.values[(i + n - 1) % n] + x.values[(i + 1) % n]);
+				}
+			}
+		};
+
+	}
+
+	TEST(Krylov, CG) {
+
+		const int n = 40;
+		TestOperator op{ n };
+
+		// a known solution and the corresponding right-hand side
+		TestVector solution{ std::vector<double>(n) };
+		for(int i = 0; i < n; ++i) {
+			solution.values[i] = std::sin(0.3 * i) + 0.01 * i;
+		}
+		TestVector b{ std::vector<double>(n) };
+		op(solution, b);
+
+		for(double initial : { 0.0, 1.0 }) {
+			TestVector x{ std::vector<double>(n, initial) };
+			auto stats = solveCG(op, b, x, 1e-10, 1000);
+			EXPECT_TRUE(stats.converged) << initial;
+			EXPECT_LE(stats.residual, 1e-10) << initial;
+			EXPECT_LE(stats.iterations, unsigned(n)) << initial;
+			for(int i = 0; i < n; ++i) {
+				EXPECT_NEAR(solution.values[i], x.values[i], 1e-8) << initial << ": " << i;
+			}
+		}
+
+		// the solution is not touched if it already satisfies the tolerance
+		TestVector y = solution;
+		auto stats = solveCG(op, b, y, 1e-10, 1000);
+		EXPECT_TRUE(stats.converged);
+		EXPECT_EQ(0u, stats.iterations);
+
+		// the solution of a zero right-hand side is zero
+		TestVector zero{ std::vector<double>(n, 0.0) };
+		TestVector x{ std::vector<double>(n, 1.0) };
+		stats = solveCG(op, zero, x, 1e-10, 1000);
+		EXPECT_TRUE(stats.converged);
+		EXPECT_EQ(0u, stats.iterations);
+		EXPECT_EQ(0.0, dotProduct(x, x));
+
+		// limits on the number of iterations are respected
+		TestVector z{ std::vector<double>(n, 0.0) };
+		stats = solveCG(op, b, z, 1e-14, 3);
+		EXPECT_FALSE(stats.converged);
+		EXPECT_EQ(3u, stats.iterations);
+		EXPECT_LT(stats.residual, 1.0);
+	}
+
+} // end namespace utils
+} // end namespace ipic3d
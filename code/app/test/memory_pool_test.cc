@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "ipic3d/app/particle_sorting.h"
+#include "ipic3d/app/utils/memory_pool.h"
+
+#include "random_particles.h"
+
+namespace ipic3d {
+namespace utils {
+
+	TEST(MemoryPool, Alignment) {
+
+		MemoryPool pool;
+		for(std::size_t bytes : { 1, 7, 64, 100, 4096, 5000 }) {
+			void* block = pool.allocate(bytes);
+			EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(block) % MemoryPool::alignment) << bytes;
+			pool.release(block, bytes);
+		}
+
+		// also large blocks are aligned
+		void* large = pool.allocate(MemoryPool::maxBlockSize + 1);
+		EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(large) % MemoryPool::alignment);
+		pool.release(large, MemoryPool::maxBlockSize + 1);
+		EXPECT_EQ(64u + 128u + 4096u + 8192u, pool.getCachedBytes());
+	}
+
+	TEST(MemoryPool, Recycling) {
+
+		MemoryPool pool;
+		EXPECT_EQ(0u, pool.getCachedBytes());
+
+		void* a = pool.allocate(1000);
+		void* b = pool.allocate(1000);
+		EXPECT_NE(a, b);
+
+		// released blocks are reused by requests of the same size class
+		pool.release(a, 1000);
+		EXPECT_EQ(1024u, pool.getCachedBytes());
+		auto allocations = MemoryPool::getNumSystemAllocations();
+		EXPECT_EQ(a, pool.allocate(1024));
+		EXPECT_EQ(allocations, MemoryPool::getNumSystemAllocations());
+		EXPECT_EQ(0u, pool.getCachedBytes());
+
+		// but not by other size classes
+		pool.release(b, 1000);
+		void* c = pool.allocate(2000);
+		EXPECT_NE(b, c);
+		EXPECT_EQ(allocations + 1, MemoryPool::getNumSystemAllocations());
+
+		pool.release(a, 1024);
+		pool.release(c, 2000);
+		EXPECT_EQ(1024u + 1024u + 2048u, pool.getCachedBytes());
+
+		pool.release();
+		EXPECT_EQ(0u, pool.getCachedBytes());
+	}
+
+	TEST(MemoryPool, Allocator) {
+
+		PooledVector<int> list;
+		for(int i = 0; i < 1000; i++) {
+			list.push_back(i);
+		}
+		for(int i = 0; i < 1000; i++) {
+			EXPECT_EQ(i, list[i]);
+		}
+
+		// re-creating the vector does not involve the system
+		list = PooledVector<int>();
+		auto allocations = MemoryPool::getNumSystemAllocations();
+		for(int i = 0; i < 1000; i++) {
+			list.push_back(i);
+		}
+		EXPECT_EQ(allocations, MemoryPool::getNumSystemAllocations());
+	}
+
+	TEST(MemoryPool, ParticleStoreSteadyState) {
+
+		ParticleStore particles = createRandomParticles(1000, Vector3<double>(0.0), Vector3<double>(1.0));
+
+		auto step = [&](unsigned levels) {
+			sortParticlesBySubCell(particles, levels);
+			ParticleStore copy = particles;
+			EXPECT_EQ(particles.size(), copy.size());
+		};
+
+		// warm up
+		step(1);
+		step(2);
+
+		// from now on, re-arranging and copying the store is served by the pool
+		auto allocations = MemoryPool::getNumSystemAllocations();
+		for(int i = 0; i < 10; i++) {
+			step(1 + i % 2);
+		}
+		EXPECT_EQ(allocations, MemoryPool::getNumSystemAllocations());
+	}
+
+} // end namespace utils
+} // end namespace ipic3d
@@ -77,6 +77,7 @@ namespace ipic3d {
 		EXPECT_TRUE( params.SaveDirName.compare("data") == 0 );
 
 		EXPECT_TRUE( params.PoissonCorrection.compare("no") == 0 );
+		EXPECT_EQ(params.PoissonCorrectionCycle, 10);
 
 		EXPECT_NEAR(params.B0.x, 0.0, 1e-15);
 		EXPECT_NEAR(params.B0.y, 0.0, 1e-15);
@@ -86,6 +87,11 @@ namespace ipic3d {
 		EXPECT_NEAR(params.B1.y, 0.0, 1e-15);
 		EXPECT_NEAR(params.B1.z, 2.0, 1e-15);
 
+		EXPECT_NEAR(params.th, 1.0, 1e-15);
+		EXPECT_NEAR(params.CGtol, 1e-3, 1e-15);
+		EXPECT_NEAR(params.GMREStol, 1e-3, 1e-15);
+		EXPECT_EQ(params.FieldSolverMaxIterations, 200);
+
 		EXPECT_EQ(params.FieldOutputCycle, 1);
 		EXPECT_TRUE( params.FieldOutputTag.compare("B+E+Je+Ji") == 0 );
 		EXPECT_TRUE( params.MomentsOutputTag.compare("rho+PXX+PXY+PXZ+PYY+PYZ+PZZ") == 0 );
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "ipic3d/app/particle_sorting.h"
+
+#include "random_particles.h"
+
+namespace ipic3d {
+
+	// particles within the unit box, the frame of a cell
+	ParticleStore createRandomParticlesInBox(std::size_t num, std::uint32_t seed = 0) {
+		return createRandomParticles(num, Vector3<double>(0.0), Vector3<double>(1.0), seed);
+	}
+
+	TEST(SubCellKey, Morton) {
+
+		// a single level splits the cell into octants
+		EXPECT_EQ(0u, getSubCellKey(0.2, 0.2, 0.2, 1));
+		EXPECT_EQ(1u, getSubCellKey(0.2, 0.2, 0.7, 1));
+		EXPECT_EQ(2u, getSubCellKey(0.2, 0.7, 0.2, 1));
+		EXPECT_EQ(4u, getSubCellKey(0.7, 0.2, 0.2, 1));
+		EXPECT_EQ(7u, getSubCellKey(0.7, 0.7, 0.7, 1));
+
+		// further levels refine octants
+		EXPECT_EQ(0u, getSubCellKey(0.1, 0.1, 0.1, 2));
+		EXPECT_EQ(1u, getSubCellKey(0.1, 0.1, 0.3, 2));
+		EXPECT_EQ(8u, getSubCellKey(0.1, 0.1, 0.6, 2));
+		EXPECT_EQ(63u, getSubCellKey(0.9, 0.9, 0.9, 2));
+
+		// positions on or beyond the boundary are mapped to the closest sub-cell
+		EXPECT_EQ(0u, getSubCellKey(0.0, 0.0, 0.0, 2));
+		EXPECT_EQ(63u, getSubCellKey(1.0, 1.0, 1.0, 2));
+		EXPECT_EQ(3u, getSubCellKey(-0.1, 1.1, 1.1, 1));
+		EXPECT_EQ(0u, getSubCellKey(std::nan(""), 0.0, 0.0, 2));
+	}
+
+	TEST(SubCellSorting, Sort) {
+
+		// the index of each particle is stored in its velocity
+		auto particles = createRandomParticlesInBox(1000, 3);
+		auto* vz = particles.data(ParticleStore::VZ);
+		for(std::size_t i = 0; i < particles.size(); i++) {
+			vz[i] = particle_storage_type(i);
+		}
+		auto reference = particles;
+
+		const auto capacity = particles.capacity();
+		sortParticlesBySubCell(particles, 2);
+		ASSERT_EQ(reference.size(), particles.size());
+
+		// particles are rearranged in place, keeping the species table
+		EXPECT_EQ(capacity, particles.capacity());
+		EXPECT_TRUE(reference.getSpecies() == particles.getSpecies());
+
+		// particles are sorted by their keys
+		SubCellKeys keys;
+		getSubCellKeys(particles, 2, keys);
+		EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+		EXPECT_EQ(0u, countUnorderedParticles(keys));
+
+		// all particles are retained
+		std::vector<bool> found(reference.size(), false);
+		for(std::size_t i = 0; i < particles.size(); i++) {
+			Particle p = particles[i];
+			std::size_t index = std::size_t(p.velocity.z);
+			ASSERT_LT(index, reference.size());
+			EXPECT_FALSE(found[index]);
+			found[index] = true;
+			Particle r = reference[index];
+			EXPECT_EQ(r.position, p.position);
+			EXPECT_EQ(r.velocity, p.velocity);
+			EXPECT_EQ(r.q, p.q);
+			EXPECT_EQ(r.qom, p.qom);
+		}
+
+		// particles within a sub-cell retain their relative order
+		for(std::size_t i = 1; i < particles.size(); i++) {
+			if (keys[i] != keys[i - 1]) continue;
+			EXPECT_LT(Particle(particles[i - 1]).velocity.z, Particle(particles[i]).velocity.z);
+		}
+	}
+
+	TEST(SubCellSorting, Trigger) {
+
+		SubCellSorting config;
+		config.minParticles = 100;
+		config.maxDisorder = 0.1;
+
+		// small cells are not sorted
+		auto small = createRandomParticlesInBox(50);
+		EXPECT_FALSE(sortParticlesBySubCellIfDisordered(small, config));
+
+		// disordered cells are sorted once
+		auto particles = createRandomParticlesInBox(500);
+		EXPECT_TRUE(sortParticlesBySubCellIfDisordered(particles, config));
+		EXPECT_FALSE(sortParticlesBySubCellIfDisordered(particles, config));
+
+		// a few appended particles are tolerated
+		auto immigrants = createRandomParticlesInBox(20, 1);
+		particles.append(immigrants);
+		EXPECT_FALSE(sortParticlesBySubCellIfDisordered(particles, config));
+
+		// yet not too many
+		immigrants = createRandomParticlesInBox(200, 2);
+		particles.append(immigrants);
+		EXPECT_TRUE(sortParticlesBySubCellIfDisordered(particles, config));
+
+		SubCellKeys keys;
+		getSubCellKeys(particles, config.levels, keys);
+		EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+	}
+
+} // end namespace ipic3d
@@ -0,0 +1,296 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "ipic3d/app/particle_store.h"
+
+namespace ipic3d {
+
+	Particle createParticle(double i) {
+		Particle p;
+		p.position = { i, i + 0.1, i + 0.2 };
+		p.velocity = { -i, -i - 0.1, -i - 0.2 };
+		p.q = 2 * i;
+		p.qom = 3 * i;
+		return p;
+	}
+
+	TEST(ParticleStore, Basic) {
+
+		ParticleStore store;
+		EXPECT_TRUE(store.empty());
+		EXPECT_EQ(0, store.size());
+
+		// add some particles
+		for(int i = 0; i < 10; i++) {
+			store.push_back(createParticle(i));
+		}
+
+		EXPECT_FALSE(store.empty());
+		EXPECT_EQ(10, store.size());
+
+		// check that the particles can be retrieved
+		for(int i = 0; i < 10; i++) {
+			Particle p = store[i];
+			EXPECT_EQ(Vector3<double>({ i + 0.0, i + 0.1, i + 0.2 }), p.position);
+			EXPECT_EQ(Vector3<double>({ -i - 0.0, -i - 0.1, -i - 0.2 }), p.velocity);
+			EXPECT_EQ(2.0 * i, p.q);
+			EXPECT_EQ(3.0 * i, p.qom);
+		}
+
+		// particles can be exchanged
+		store.swap(2, 7);
+		EXPECT_EQ(7.0, store[2].position.x);
+		EXPECT_EQ(2.0, store[7].position.x);
+		EXPECT_EQ(4.0, store[7].q);
+		EXPECT_EQ(6.0, store[7].qom);
+		store.swap(7, 2);
+		EXPECT_EQ(2.0, store[2].position.x);
+
+		// the remaining particles are removed
+		store.pop_back();
+		EXPECT_EQ(9, store.size());
+		EXPECT_EQ(8.0, store.back().position.x);
+
+		store.clear();
+		EXPECT_TRUE(store.empty());
+	}
+
+	TEST(ParticleStore, Layout) {
+
+		ParticleStore store;
+		store.push_back(createParticle(1));
+
+		// the capacity is padded to the SIMD width
+		EXPECT_EQ(0, store.capacity() % ParticleStore::simdWidth);
+
+		// all property arrays are aligned to cache lines
+		for(int c = 0; c < ParticleStore::NUM_COMPONENTS; c++) {
+			auto addr = reinterpret_cast<std::uintptr_t>(store.data(ParticleStore::Component(c)));
+			EXPECT_EQ(0, addr % ParticleStore::alignment);
+		}
+
+		// and the padding is zero-initialized
+		for(std::size_t i = store.size(); i < store.capacity(); i++) {
+			EXPECT_EQ(0.0, store.data(ParticleStore::X)[i]);
+			EXPECT_EQ(0.0, store.data(ParticleStore::VZ)[i]);
+		}
+
+		// properties are stored in separate arrays
+		EXPECT_EQ(1.0, store.data(ParticleStore::X)[0]);
+		EXPECT_EQ(1.1, store.data(ParticleStore::Y)[0]);
+		EXPECT_EQ(-1.2, store.data(ParticleStore::VZ)[0]);
+		EXPECT_EQ(0, store.getSpeciesIds()[0]);
+		EXPECT_EQ(3.0, store.getSpecies()[0].qom);
+
+		// capacity is retained when clearing the store
+		auto capacity = store.capacity();
+		store.clear();
+		EXPECT_EQ(capacity, store.capacity());
+	}
+
+	TEST(ParticleStore, ReferenceProxy) {
+
+		ParticleStore store;
+		store.push_back(createParticle(1));
+		store.push_back(createParticle(2));
+
+		// modifications through references are applied to the store
+		auto p = store.front();
+		p.velocity.x = 5.0;
+		p.position += Vector3<double>(1.0);
+		EXPECT_EQ(5.0, store[0].velocity.x);
+		EXPECT_EQ(2.0, store[0].position.x);
+		EXPECT_EQ(2.2, store[0].position.z);
+
+		// references may be assigned whole particles
+		store[1] = createParticle(7);
+		EXPECT_EQ(7.0, store[1].position.x);
+		EXPECT_EQ(14.0, store[1].q);
+
+		// and copies of referenced particles are independent
+		Particle c = store[1];
+		c.position.x = 0.0;
+		EXPECT_EQ(0.0, c.position.x);
+		EXPECT_EQ(7.0, store[1].position.x);
+	}
+
+	TEST(ParticleStore, Species) {
+
+		ParticleStore a;
+		a.push_back(createParticle(1));
+		a.push_back(createParticle(2));
+		a.push_back(createParticle(1));
+
+		// particles of the same species share an entry of the species table
+		EXPECT_EQ(2, a.getSpecies().size());
+		EXPECT_EQ(0, a.getSpeciesIds()[0]);
+		EXPECT_EQ(1, a.getSpeciesIds()[1]);
+		EXPECT_EQ(0, a.getSpeciesIds()[2]);
+		EXPECT_EQ(2.0 / 3.0, a.getSpecies()[0].getMass());
+
+		// updating a property through a reference moves the particle to another species
+		a[2].q = 4.0;
+		EXPECT_EQ(3, a.getSpecies().size());
+		EXPECT_EQ(2, a.getSpeciesIds()[2]);
+		a[2].qom = 6.0;
+		EXPECT_EQ(1, a.getSpeciesIds()[2]);
+		EXPECT_EQ(4.0, a[2].q);
+
+		// assigning a whole particle does not register intermediate species
+		a[1] = createParticle(5);
+		EXPECT_EQ(4, a.getSpecies().size());
+		a[1] = createParticle(2);
+		EXPECT_EQ(4, a.getSpecies().size());
+
+		// appending translates species ids between stores, only registering the species in use
+		ParticleStore b;
+		b.push_back(createParticle(2));
+		b.append(a);
+		EXPECT_EQ(4, b.size());
+		EXPECT_EQ(2, b.getSpecies().size());
+		EXPECT_EQ(2.0, b[1].q);
+		EXPECT_EQ(4.0, b[2].q);
+		EXPECT_EQ(6.0, b[3].qom);
+		EXPECT_EQ(b.getSpeciesIds()[0], b.getSpeciesIds()[2]);
+		EXPECT_EQ(b.getSpeciesIds()[0], b.getSpeciesIds()[3]);
+
+		b.append(a, 0);
+		EXPECT_EQ(2.0, b[4].q);
+		EXPECT_EQ(3.0, b[4].qom);
+
+		// resizing does not register a species, the species of new particles is set by copying particles
+		b.resize(6);
+		EXPECT_EQ(2, b.getSpecies().size());
+		EXPECT_EQ(0.0, b.data(ParticleStore::X)[5]);
+		b.copy(5, a, 1);
+		EXPECT_EQ(4.0, b[5].q);
+		EXPECT_EQ(6.0, b[5].qom);
+		EXPECT_EQ(2, b.getSpecies().size());
+	}
+
+	TEST(ParticleStore, Iteration) {
+
+		ParticleStore store;
+		for(int i = 0; i < 20; i++) {
+			store.push_back(createParticle(i));
+		}
+
+		// iterate through a const view
+		const ParticleStore& view = store;
+		double sum = 0;
+		for(const auto& p : view) {
+			sum += p.q;
+		}
+		EXPECT_EQ(2.0 * 190, sum);
+		EXPECT_EQ(20, view.end() - view.begin());
+
+		// update all particles through a mutable iteration
+		for(auto p : store) {
+			p.q = 1.0;
+		}
+		for(const auto& p : view) {
+			EXPECT_EQ(1.0, p.q);
+		}
+	}
+
+	TEST(ParticleStore, Append) {
+
+		ParticleStore a;
+		ParticleStore b;
+		for(int i = 0; i < 5; i++) {
+			a.push_back(createParticle(i));
+			b.push_back(createParticle(10 + i));
+		}
+
+		// append a range of particles
+		a.append(b, 1, 3);
+		EXPECT_EQ(7, a.size());
+		EXPECT_EQ(11.0, a[5].position.x);
+		EXPECT_EQ(12.0, a[6].position.x);
+
+		// append a single particle
+		a.append(b, 4);
+		EXPECT_EQ(8, a.size());
+		EXPECT_EQ(14.0, a[7].position.x);
+
+		// append all particles
+		a.append(b);
+		EXPECT_EQ(13, a.size());
+		EXPECT_EQ(10.0, a[8].position.x);
+		EXPECT_EQ(-14.2, a[12].velocity.z);
+
+		// copies are deep
+		ParticleStore c = a;
+		c[0].q = 100;
+		EXPECT_EQ(0.0, a[0].q);
+		EXPECT_EQ(13, c.size());
+	}
+
+	TEST(ParticleStore, Frame) {
+
+		ParticleStore store;
+		store.push_back(createParticle(1));
+
+		// by default, positions are stored as they are
+		EXPECT_EQ(Vector3<double>(0.0), store.getFrameOrigin());
+		EXPECT_EQ(Vector3<double>(1.0), store.getFrameWidth());
+		EXPECT_EQ(1.1, store.data(ParticleStore::Y)[0]);
+
+		// moving the frame retains the absolute position of particles
+		store.setFrame({ 1.0, 1.0, 1.0 }, { 0.5, 0.5, 0.5 });
+		EXPECT_EQ(0.0, store.data(ParticleStore::X)[0]);
+		EXPECT_NEAR(0.2, store.data(ParticleStore::Y)[0], 1e-12);
+		EXPECT_NEAR(0.4, store.data(ParticleStore::Z)[0], 1e-12);
+		EXPECT_NEAR(1.1, store[0].position.y, 1e-12);
+
+		// velocities are not affected
+		EXPECT_EQ(-1.1, store.data(ParticleStore::VY)[0]);
+
+		// new particles are converted into the frame
+		Particle p = createParticle(1.5);
+		store.push_back(p);
+		EXPECT_EQ(1.0, store.data(ParticleStore::X)[1]);
+		EXPECT_EQ(1.5, store[1].position.x);
+
+		// updates through references are applied in absolute coordinates
+		store[1].position.x += 0.25;
+		EXPECT_EQ(1.5, store.data(ParticleStore::X)[1]);
+		EXPECT_EQ(1.75, Particle(store[1]).position.x);
+
+		// appending particles transfers their relative positions
+		ParticleStore other;
+		other.setFrame({ 2.0, 1.0, 1.0 }, { 0.5, 0.5, 0.5 });
+		other.append(store, 1);
+		EXPECT_EQ(1.5, other.data(ParticleStore::X)[0]);
+		EXPECT_EQ(2.75, Particle(other[0]).position.x);
+
+		// copies retain the frame
+		ParticleStore copy = other;
+		EXPECT_EQ(other.getFrameOrigin(), copy.getFrameOrigin());
+		EXPECT_EQ(2.75, Particle(copy[0]).position.x);
+	}
+
+	TEST(ParticleStore, SinglePrecision) {
+
+		BasicParticleStore<float> store;
+		store.push_back(createParticle(1));
+
+		// arrays are padded to a full register of floats
+		EXPECT_EQ(16, BasicParticleStore<float>::simdWidth);
+		EXPECT_EQ(0, store.capacity() % 16);
+		auto addr = reinterpret_cast<std::uintptr_t>(store.data(BasicParticleStore<float>::VZ));
+		EXPECT_EQ(0, addr % BasicParticleStore<float>::alignment);
+
+		// values are rounded to single precision when stored
+		EXPECT_EQ(1.1f, store.data(BasicParticleStore<float>::Y)[0]);
+		Particle p = store[0];
+		EXPECT_EQ(double(1.1f), p.position.y);
+		EXPECT_EQ(3.0, p.qom);
+
+		// and updates through references are applied in double precision, then rounded
+		store[0].velocity *= 0.5;
+		EXPECT_EQ(float(-1.2f * 0.5), store[0].velocity.z);
+	}
+
+}
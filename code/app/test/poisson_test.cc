@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+#include "ipic3d/app/poisson.h"
+
+namespace ipic3d {
+
+	namespace {
+
+		// applies the 7-point Laplacian to the given periodic field with an up-to-date ghost layer
+		double applyLaplacian(const ScalarField& phi, const utils::Coordinate<3>& pos, const Vector3<double>& width) {
+			double res = 0.0;
+			for(int d = 0; d < 3; ++d) {
+				auto lower = pos;
+				auto upper = pos;
+				lower[d]--;
+				upper[d]++;
+				res += (phi[lower] - 2.0 * phi[pos] + phi[upper]) / (width[d] * width[d]);
+			}
+			return res;
+		}
+
+		void testSolve(const utils::Size<3>& size, const Vector3<double>& width, unsigned expectedLevels, unsigned maxCycles) {
+
+			PoissonSolver solver(size, width);
+			EXPECT_EQ(size, solver.size());
+			EXPECT_EQ(expectedLevels, solver.getNumLevels());
+
+			// a smooth solution of zero mean, superimposed by noise
+			ScalarField expected(size + utils::Size<3>(2));
+			std::minstd_rand rand(size.x);
+			std::uniform_real_distribution<> noise(-0.1, 0.1);
+			const double twoPI = 8.0 * std::atan(1.0);
+			allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(1), size + utils::Coordinate<3>(1), [&](const utils::Coordinate<3>& pos) {
+				expected[pos] = std::sin(twoPI * pos.x / size.x) * std::cos(twoPI * pos.y / size.y) + std::sin(2 * twoPI * pos.z / size.z) + noise(rand);
+			});
+			double mean = 0.0;
+			allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(1), size + utils::Coordinate<3>(1), [&](const utils::Coordinate<3>& pos) {
+				mean += expected[pos];
+			});
+			mean /= double(size.x * size.y * size.z);
+			allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(1), size + utils::Coordinate<3>(1), [&](const utils::Coordinate<3>& pos) {
+				expected[pos] -= mean;
+			});
+			updatePeriodicHalo(expected, [](double& ghost, const double& source) { ghost = source; });
+
+			// the right-hand side is shifted by a constant, which is not solvable and thus ignored
+			auto& rhs = solver.getRightHandSide();
+			allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(1), size + utils::Coordinate<3>(1), [&](const utils::Coordinate<3>& pos) {
+				rhs[pos] = applyLaplacian(expected, pos, width) + 3.0;
+			});
+
+			auto stats = solver.solve(1e-10, maxCycles);
+			EXPECT_TRUE(stats.converged) << size << ": " << stats.residual << " after " << stats.iterations << " cycles";
+			EXPECT_LE(stats.residual, 1e-10);
+			EXPECT_LT(0u, stats.iterations);
+
+			const auto& phi = solver.getSolution();
+			allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), size + utils::Coordinate<3>(2), [&](const utils::Coordinate<3>& pos) {
+				EXPECT_NEAR(expected[pos], phi[pos], 1e-7) << size << ": " << pos;
+			});
+
+			// solving again starts from the current solution
+			stats = solver.solve(1e-10, maxCycles);
+			EXPECT_TRUE(stats.converged);
+			EXPECT_EQ(0u, stats.iterations);
+		}
+
+	}
+
+	TEST(PoissonSolver, Multigrid) {
+
+		// the number of cycles does not depend on the size of the grid
+		testSolve({ 8,8,8 }, { 1.0,1.0,1.0 }, 3, 15);
+		testSolve({ 16,16,16 }, { 1.0,1.0,1.0 }, 4, 15);
+
+		// different cell widths along the dimensions
+		testSolve({ 16,16,16 }, { 0.5,0.4,0.6 }, 4, 20);
+	}
+
+	TEST(PoissonSolver, IrregularSizes) {
+
+		// sizes which are not powers of two are coarsened down to 2 elements as well, converging as fast
+		testSolve({ 12,12,12 }, { 1.0,1.0,1.0 }, 4, 15);
+		testSolve({ 5,5,5 }, { 1.0,1.0,1.0 }, 3, 15);
+		testSolve({ 25,25,25 }, { 1.0,1.0,1.0 }, 5, 15);
+		testSolve({ 4,6,10 }, { 1.0,1.0,1.0 }, 4, 15);
+		testSolve({ 18,7,11 }, { 0.5,0.4,0.6 }, 5, 20);
+		testSolve({ 2,1,3 }, { 1.0,1.0,1.0 }, 2, 15);
+	}
+
+	TEST(PoissonSolver, ZeroRightHandSide) {
+
+		PoissonSolver solver({ 4,4,4 }, { 1.0,1.0,1.0 });
+		auto& rhs = solver.getRightHandSide();
+		allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(1), utils::Coordinate<3>(5), [&](const utils::Coordinate<3>& pos) {
+			rhs[pos] = 2.0;
+		});
+
+		// a constant right-hand side has no solvable part
+		auto stats = solver.solve(1e-10);
+		EXPECT_TRUE(stats.converged);
+		EXPECT_EQ(0u, stats.iterations);
+		allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), utils::Coordinate<3>(6), [&](const utils::Coordinate<3>& pos) {
+			EXPECT_EQ(0.0, solver.getSolution()[pos]) << pos;
+		});
+	}
+
+} // end namespace ipic3d
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+#include "ipic3d/app/particle.h"
+#include "ipic3d/app/particle_store.h"
+#include "ipic3d/app/vector.h"
+
+namespace ipic3d {
+
+	/**
+	 * Creates the given number of particles, uniformly distributed within the box [low,low+width)
+	 * and moving with random velocities within (-1,1)^3. Particles alternate between two species,
+	 * starting with electrons (q = -1, qom = -25) followed by ions (q = 1, qom = 1). Equal seeds
+	 * yield equal particles.
+	 *
+	 * @tparam Container the container to be filled, e.g. a particle store or a vector of particles
+	 * @param num the number of particles to create
+	 * @param low the lower corner of the box
+	 * @param width the extent of the box
+	 * @param seed the seed of the random number generator
+	 */
+	template<typename Container = ParticleStore>
+	Container createRandomParticles(std::size_t num, const Vector3<double>& low, const Vector3<double>& width, std::uint32_t seed = 0) {
+		std::minstd_rand rand(seed);
+		std::uniform_real_distribution<> rel(0.0, 1.0);
+		std::uniform_real_distribution<> vel(-1.0, 1.0);
+
+		Container res;
+		for(std::size_t i = 0; i < num; i++) {
+			Particle p;
+			p.position = low + elementwiseProduct(Vector3<double>{ rel(rand), rel(rand), rel(rand) }, width);
+			p.velocity = { vel(rand), vel(rand), vel(rand) };
+			p.q = (i % 2) ? 1.0 : -1.0;
+			p.qom = (i % 2) ? 1.0 : -25.0;
+			res.push_back(p);
+		}
+		return res;
+	}
+
+} // end namespace ipic3d
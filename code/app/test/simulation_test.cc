@@ -1,9 +1,16 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+#include <vector>
+
 #include "ipic3d/app/simulator.h"
 #include "ipic3d/app/universe.h"
 #include "ipic3d/app/common.h"
 
+#include "random_particles.h"
+
 #include "allscale/api/user/algorithm/pfor.h"
 
 namespace ipic3d {
@@ -79,7 +86,7 @@ namespace ipic3d {
 			EXPECT_EQ(1.0, a.particles.front().q);
 
 			// change velocity and send in x direction
-			Particle& p2 = a.particles.front();
+			auto p2 = a.particles.front();
 			p2.velocity.x = 1.0;
 			p2.velocity.y = p2.velocity.z = 0.0;
 
@@ -132,6 +139,265 @@ namespace ipic3d {
 	}
 
 
+	// adds the given number of random particles to each cell of the given universe, see createRandomParticles, with their
+	// charges scaled by the given factor; the particles of a cell only depend on its position, thus universes of the same
+	// properties obtain the same particles
+	void addRandomParticles(Universe& universe, std::size_t numPerCell, double chargeScale = 1.0) {
+		const auto& properties = universe.properties;
+		allscale::api::user::algorithm::pfor(properties.size, [&](const utils::Coordinate<3>& pos) {
+			auto seed = std::uint32_t((pos.x * 17 + pos.y) * 17 + pos.z);
+			for(auto p : createRandomParticles<std::vector<Particle>>(numPerCell, getOriginOfCell(pos, properties), properties.cellWidth, seed)) {
+				p.q *= chargeScale;
+				universe.cells[pos].particles.push_back(p);
+			}
+		});
+	}
+
+	// the particles of the given cell, ordered by their position
+	std::vector<Particle> getSortedParticles(const Cell& cell) {
+		std::vector<Particle> res(cell.particles.begin(), cell.particles.end());
+		std::sort(res.begin(), res.end(), [](const Particle& x, const Particle& y) {
+			return std::tie(x.position.x, x.position.y, x.position.z) < std::tie(y.position.x, y.position.y, y.position.z);
+		});
+		return res;
+	}
+
+	// checks that the cells of the given universes contain the same particles, yet possibly ordered differently, located in their cells
+	void expectEqualParticlesInAnyOrder(const Universe& universe, const Universe& reference) {
+		EXPECT_EQ(countParticlesInDomain(reference), countParticlesInDomain(universe));
+		allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), universe.properties.size, [&](const utils::Coordinate<3>& pos) {
+			auto x = getSortedParticles(reference.cells[pos]);
+			auto y = getSortedParticles(universe.cells[pos]);
+			ASSERT_EQ(x.size(), y.size()) << pos;
+			for(std::size_t l = 0; l < x.size(); l++) {
+				EXPECT_EQ(x[l].position, y[l].position) << pos;
+				EXPECT_EQ(x[l].velocity, y[l].velocity) << pos;
+			}
+			EXPECT_TRUE(verifyCorrectParticlesPositionInCell(universe.properties, universe.cells[pos], pos)) << pos;
+		});
+	}
+
+	TEST(Simulation, SubCycleGroupingMover) {
+
+		// this test checks that grouping particles by their sub-cycles does not alter the simulation
+
+		UniverseProperties properties;
+		properties.size = { 4,4,4 };
+		properties.cellWidth = { 1,1,1 };
+		properties.origin = { -2,-2,-2 };
+		properties.dt = 0.1;
+		properties.planetRadius = 0.5;
+		properties.externalMagneticField = { 0,0,10 };
+
+		Universe a = Universe(properties);
+		Universe b = Universe(properties);
+		addRandomParticles(a, 50);
+		addRandomParticles(b, 50);
+
+		unsigned numSteps = 5;
+		simulateSteps<detail::default_particle_to_field_projector, detail::default_field_solver, detail::default_particle_mover>(numSteps, a);
+		simulateSteps<detail::default_particle_to_field_projector, detail::default_field_solver, detail::sub_cycle_grouping_particle_mover>(numSteps, b);
+
+		expectEqualParticlesInAnyOrder(b, a);
+	}
+
+	TEST(Simulation, FieldInterpolatingMover) {
+
+		// this test checks that particles are moved through the field stored in the universe
+
+		UniverseProperties properties;
+		properties.size = { 3,3,3 };
+		properties.cellWidth = { 1,1,1 };
+		properties.origin = { -1.5,-1.5,-1.5 };
+		properties.dt = 0.1;
+		properties.planetRadius = 0.0;
+		properties.objectCenter = { 10,10,10 };
+
+		Universe universe = Universe(properties);
+
+		// a uniform field
+		Vector3<double> E = { 0.0, 0.1, 0.0 };
+		Vector3<double> B = { 0.0, 0.0, 2.0 };
+		allscale::api::user::algorithm::pfor(universe.field.size(), [&](const utils::Coordinate<3>& pos) {
+			universe.field[pos].E = E;
+			universe.field[pos].B = B;
+		});
+
+		// a particle gyrating within the center cell
+		Particle p;
+		p.position = { 0.2, 0.0, 0.0 };
+		p.velocity = { 0.0, 0.2, 0.0 };
+		p.q = p.qom = 1.0;
+		universe.cells[{1,1,1}].particles.push_back(p);
+
+		unsigned numSteps = 10;
+		simulateSteps<detail::default_particle_to_field_projector, detail::default_field_solver, detail::field_interpolating_particle_mover>(numSteps, universe);
+
+		for(unsigned i = 0; i < numSteps; i++) {
+			p.updateVelocity(E, B, properties.dt);
+			p.updatePosition(properties.dt);
+		}
+
+		ASSERT_EQ(1, countParticlesInDomain(universe));
+		const Cell& center = universe.cells[{1,1,1}];
+		ASSERT_EQ(1, center.particles.size());
+		Particle res = center.particles.front();
+		EXPECT_LT(norm(p.position - res.position), 1e-12);
+		EXPECT_LT(norm(p.velocity - res.velocity), 1e-12);
+
+		// the electric field causes a drift
+		EXPECT_NE(0.2, norm(res.velocity));
+	}
+
+	// the properties of a small periodic universe without a planet, for comparing the time loop with a reference
+	UniverseProperties getComparisonProperties() {
+		UniverseProperties properties;
+		properties.size = { 4,4,4 };
+		properties.cellWidth = { 1,1,1 };
+		properties.origin = { -2,-2,-2 };
+		properties.dt = 0.5;
+		properties.planetRadius = 0.0;
+		properties.objectCenter = { 10,10,10 };
+		return properties;
+	}
+
+	// initializes the given universes of the same size with the same particles and fields, moving particles across cells
+	void initEqually(Universe& universe, Universe& reference) {
+		addRandomParticles(universe, 4, 0.1);
+		addRandomParticles(reference, 4, 0.1);
+		allscale::api::user::algorithm::pfor(universe.field.size(), [&](const utils::Coordinate<3>& pos) {
+			universe.field[pos].E = reference.field[pos].E = { 0.01 * std::sin(pos.y), 0.01 * pos.x, 0.01 * std::cos(pos.z) };
+			universe.field[pos].B = reference.field[pos].B = Vector3<double>(0.0);
+			universe.field[pos].Bext = reference.field[pos].Bext = Vector3<double>(0.0);
+		});
+		allscale::api::user::algorithm::pfor(universe.bcfield.size(), [&](const utils::Coordinate<3>& pos) {
+			universe.bcfield[pos].Bc = reference.bcfield[pos].Bc = { 0.0, 0.1 * std::cos(pos.x), 0.02 * pos.y };
+		});
+		allscale::api::user::algorithm::pfor(universe.currentDensity.size(), [&](const utils::Coordinate<3>& pos) {
+			universe.currentDensity[pos].J = reference.currentDensity[pos].J = Vector3<double>(0.0);
+		});
+	}
+
+	// checks that the cells of the given universes contain the same particles, in the same order
+	void expectEqualParticles(const Universe& universe, const Universe& reference) {
+		allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), universe.properties.size, [&](const utils::Coordinate<3>& pos) {
+			const auto& a = universe.cells[pos].particles;
+			const auto& b = reference.cells[pos].particles;
+			ASSERT_EQ(b.size(), a.size()) << pos;
+			for(std::size_t i = 0; i < a.size(); ++i) {
+				EXPECT_EQ(b[i].position, a[i].position) << pos;
+				EXPECT_EQ(b[i].velocity, a[i].velocity) << pos;
+			}
+		});
+	}
+
+	TEST(Simulation, ImplicitMaxwellSolver) {
+
+		// this test checks that global field solvers are applied once per time step, driven by the current of the particles
+
+		UniverseProperties properties = getComparisonProperties();
+		Universe universe(properties);
+		Universe reference(properties);
+		initEqually(universe, reference);
+
+		unsigned numSteps = 3;
+		simulateSteps<detail::default_particle_to_field_projector, detail::implicit_maxwell_field_solver, detail::field_interpolating_particle_mover>(numSteps, universe);
+
+		// the reference projects the particles and solves the fields explicitly before each step
+		for(unsigned i = 0; i < numSteps; i++) {
+			projectToDensityField(properties, reference.cells, reference.currentDensity);
+			EXPECT_TRUE(solveFieldImplicitMaxwell(properties, reference.currentDensity, reference.field, reference.bcfield).converged);
+			simulateSteps<detail::default_particle_to_field_projector, detail::default_field_solver, detail::field_interpolating_particle_mover>(1, reference);
+		}
+
+		// the current density got updated
+		double current = 0.0;
+		allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), universe.currentDensity.size(), [&](const utils::Coordinate<3>& pos) {
+			EXPECT_EQ(reference.currentDensity[pos].J, universe.currentDensity[pos].J) << pos;
+			current += allscale::utils::sumOfSquares(universe.currentDensity[pos].J);
+		});
+		EXPECT_LT(0.0, current);
+
+		allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), universe.field.size(), [&](const utils::Coordinate<3>& pos) {
+			EXPECT_EQ(reference.field[pos].E, universe.field[pos].E) << pos;
+			EXPECT_EQ(reference.field[pos].B, universe.field[pos].B) << pos;
+		});
+		allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), universe.bcfield.size(), [&](const utils::Coordinate<3>& pos) {
+			EXPECT_EQ(reference.bcfield[pos].Bc, universe.bcfield[pos].Bc) << pos;
+		});
+		expectEqualParticles(universe, reference);
+		EXPECT_EQ(4 * 64u, countParticlesInDomain(universe));
+	}
+
+	TEST(Simulation, PoissonCorrection) {
+
+		// this test checks that the divergence of the electric field is cleaned every poissonCorrectionCycle steps
+
+		UniverseProperties properties = getComparisonProperties();
+		properties.CGtol = 1e-8;
+
+		auto cleaning = properties;
+		cleaning.poissonCorrectionCycle = 2;
+
+		Universe universe(cleaning);
+		Universe reference(properties);
+		initEqually(universe, reference);
+
+		simulateSteps<detail::default_particle_to_field_projector, detail::default_field_solver, detail::field_interpolating_particle_mover>(3, universe);
+
+		// the reference applies the corrections of steps 0 and 2 explicitly
+		ChargeDensity density = initChargeDensity(properties);
+		PoissonSolver solver(properties.size, properties.cellWidth);
+		auto correct = [&]() {
+			projectToChargeDensity(properties, reference.cells, density);
+			EXPECT_TRUE(correctElectricField(properties, density, reference.field, solver).converged);
+		};
+		correct();
+		simulateSteps<detail::default_particle_to_field_projector, detail::default_field_solver, detail::field_interpolating_particle_mover>(2, reference);
+		correct();
+		simulateSteps<detail::default_particle_to_field_projector, detail::default_field_solver, detail::field_interpolating_particle_mover>(1, reference);
+
+		allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), universe.field.size(), [&](const utils::Coordinate<3>& pos) {
+			EXPECT_EQ(reference.field[pos].E, universe.field[pos].E) << pos;
+		});
+		expectEqualParticles(universe, reference);
+		EXPECT_EQ(4 * 64u, countParticlesInDomain(universe));
+	}
+
+	TEST(Simulation, Tiles) {
+
+		// this test checks that the tile width does not alter the simulation
+
+		auto run = [](unsigned tileWidth) {
+			UniverseProperties properties;
+			properties.size = { 6,6,6 };
+			properties.cellWidth = { .25,.25,.25 };
+			properties.origin = { -.75,-.75,-.75 };
+			properties.dt = 0.1;
+			properties.planetRadius = 0.1;
+			properties.externalMagneticField = { 0,0,1 };
+			properties.tileWidth = tileWidth;
+
+			Universe universe = Universe(properties);
+
+			// fill the universe with fast particles, crossing cells frequently
+			addRandomParticles(universe, 20);
+
+			simulateSteps(10, universe);
+			return universe;
+		};
+
+		// a tile per cell passes all particles through the transfer buffers
+		Universe reference = run(1);
+		EXPECT_LT(0, countParticlesInDomain(reference));
+
+		for(unsigned tileWidth : { 2, 4, 8 }) {
+			SCOPED_TRACE(testing::Message() << "Tile width " << tileWidth);
+			Universe universe = run(tileWidth);
+			expectEqualParticlesInAnyOrder(universe, reference);
+		}
+	}
+
 	TEST(Simulation, SingleParticleBorisMover) {
 
 		// Set universe properties
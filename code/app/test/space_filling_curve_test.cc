@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "ipic3d/app/utils/space_filling_curve.h"
+
+namespace ipic3d {
+namespace utils {
+
+	TEST(MortonCode, Basic) {
+		EXPECT_EQ(0u, getMortonCode({ 0,0,0 }));
+		EXPECT_EQ(1u, getMortonCode({ 0,0,1 }));
+		EXPECT_EQ(2u, getMortonCode({ 0,1,0 }));
+		EXPECT_EQ(4u, getMortonCode({ 1,0,0 }));
+		EXPECT_EQ(7u, getMortonCode({ 1,1,1 }));
+		EXPECT_EQ(8u, getMortonCode({ 0,0,2 }));
+		EXPECT_EQ(63u, getMortonCode({ 3,3,3 }));
+		EXPECT_EQ(0x7FFFFFFFFFFFFFFFull, getMortonCode({ 0x1FFFFF,0x1FFFFF,0x1FFFFF }));
+	}
+
+	TEST(MortonOrder, Traversal) {
+		Coordinate<3> begin = { 1,2,3 };
+		Coordinate<3> end = { 6,5,11 };
+
+		std::vector<Coordinate<3>> visited;
+		forEachInMortonOrder(begin, end, [&](const Coordinate<3>& pos) {
+			visited.push_back(pos);
+		});
+
+		// all points are visited
+		ASSERT_EQ(5 * 3 * 8, (int) visited.size());
+		for(const auto& pos : visited) {
+			EXPECT_TRUE(begin.dominatedBy(pos)) << pos;
+			EXPECT_TRUE(pos.strictlyDominatedBy(end)) << pos;
+		}
+
+		// in ascending order of their code, thus each once
+		for(std::size_t i = 1; i < visited.size(); i++) {
+			EXPECT_LT(getMortonCode(visited[i - 1]), getMortonCode(visited[i]));
+		}
+
+		// empty ranges are not visited
+		int count = 0;
+		forEachInMortonOrder(begin, Coordinate<3>({ 6,2,11 }), [&](const Coordinate<3>&) { count++; });
+		EXPECT_EQ(0, count);
+	}
+
+	TEST(MortonOrder, ParallelLoop) {
+		Coordinate<3> begin = 1;
+		Coordinate<3> end = { 11,6,9 };
+
+		std::vector<int> visits(12 * 12 * 12, 0);
+		auto index = [](const Coordinate<3>& pos) { return (pos.x * 12 + pos.y) * 12 + pos.z; };
+		pforInMortonOrder(begin, end, [&](const Coordinate<3>& pos) {
+			visits[index(pos)]++;
+		}).wait();
+
+		for(int i = 0; i < 12; i++) {
+			for(int j = 0; j < 12; j++) {
+				for(int k = 0; k < 12; k++) {
+					Coordinate<3> pos = { i,j,k };
+					bool inside = begin.dominatedBy(pos) && pos.strictlyDominatedBy(end);
+					EXPECT_EQ(inside ? 1 : 0, visits[index(pos)]) << pos;
+				}
+			}
+		}
+
+		// the loop covers blocks of points
+		EXPECT_EQ(Size<3>({ 3,2,2 }), getNumBlocks(begin, end));
+		EXPECT_EQ(Size<3>({ 10,5,8 }), getNumBlocks(begin, end, 1));
+		EXPECT_EQ(Size<3>({ 2,1,1 }), getNumBlocks(begin, end, 8));
+	}
+
+} // end namespace utils
+} // end namespace ipic3d
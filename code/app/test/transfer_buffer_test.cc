@@ -1,9 +1,29 @@
 #include <gtest/gtest.h>
 
+#include <set>
+
 #include "ipic3d/app/transfer_buffer.h"
 
 namespace ipic3d {
 
+	TEST(TransferDirection, Index) {
+
+		std::set<unsigned> indices;
+
+		// all directions have distinct indices within the valid range
+		for(int i=0; i<3; i++) {
+			for(int j=0; j<3; j++) {
+				for(int k=0; k<3; k++) {
+					auto index = TransferDirection(i,j,k).getIndex();
+					EXPECT_LT(index, unsigned(TransferDirection::NumDirections));
+					EXPECT_TRUE(indices.insert(index).second);
+				}
+			}
+		}
+
+		EXPECT_EQ(std::size_t(TransferDirection::NumDirections), indices.size());
+	}
+
 	TEST(TransferBuffers, Creation) {
 
 		using size_t = TransferBuffers::grid_size_t;
@@ -22,48 +42,71 @@ namespace ipic3d {
 					// create the source position
 					size_t pos(x,y,z);
 
+					auto& buffer = buffers.getBuffer(pos);
+
+					// check that the buffer is empty
+					EXPECT_TRUE(buffer.empty());
+
 					// in each direction
 					for(int i=0; i<3; i++) {
 						for(int j=0; j<3; j++) {
 							for(int k=0; k<3; k++) {
-
-								// create the direction
-								TransferDirection dir(i,j,k);
-
-								auto& buffer = buffers.getBuffer(pos,dir);
-
-								// check that the buffer is empty
-								EXPECT_TRUE(buffer.empty());
-
-								// check that this is a buffer not seen before
-								EXPECT_TRUE(all_buffers.insert(&buffer).second);
-
+								EXPECT_EQ(0, buffer.size(TransferDirection(i,j,k)));
 							}
 						}
 					}
 
+					// check that this is a buffer not seen before
+					EXPECT_TRUE(all_buffers.insert(&buffer).second);
+
 				}
 			}
 		}
 
-		EXPECT_EQ(10*12*14*3*3*3, all_buffers.size());
+		EXPECT_EQ(10*12*14, all_buffers.size());
+	}
+
+	TEST(TransferBuffer, Allocate) {
+
+		TransferBuffer buffer;
 
-		// test that particles can be added
-		auto& buffer = buffers.getBuffer({5,6,7},TransferDirection(0,1,2));
+		// reserve space for particles in two directions
+		std::array<std::size_t,TransferDirection::NumDirections> counts {};
+		counts[TransferDirection(0,1,2).getIndex()] = 2;
+		counts[TransferDirection(2,2,2).getIndex()] = 3;
+		buffer.allocate(counts);
 
-		EXPECT_TRUE(all_buffers.find(&buffer) != all_buffers.end());
+		EXPECT_EQ(5, buffer.size());
+		EXPECT_EQ(2, buffer.size(TransferDirection(0,1,2)));
+		EXPECT_EQ(3, buffer.size(TransferDirection(2,2,2)));
+		EXPECT_EQ(0, buffer.size(TransferDirection(1,1,1)));
 
-		EXPECT_EQ(0,buffer.size());
+		// ranges are consecutive and ordered by direction
+		EXPECT_EQ(0, buffer.begin(TransferDirection(0,1,2)));
+		EXPECT_EQ(buffer.end(TransferDirection(0,1,2)), buffer.begin(TransferDirection(2,2,2)));
+		EXPECT_EQ(5, buffer.end(TransferDirection(2,2,2)));
 
+		// particles can be placed within their range
 		Particle p;
-		buffer.push_back(p);
+		p.q = 2.0;
+		buffer.getParticles()[buffer.begin(TransferDirection(2,2,2))] = p;
+		EXPECT_EQ(2.0, buffer.getParticles()[2].q);
 
-		EXPECT_EQ(1,buffer.size());
+		// re-filling the buffer retains its capacity
+		auto capacity = buffer.getParticles().capacity();
+		counts.fill(0);
+		counts[TransferDirection(1,0,1).getIndex()] = 1;
+		buffer.allocate(counts);
 
-		buffer.clear();
+		EXPECT_EQ(1, buffer.size());
+		EXPECT_EQ(1, buffer.size(TransferDirection(1,0,1)));
+		EXPECT_EQ(0, buffer.size(TransferDirection(2,2,2)));
+		EXPECT_EQ(capacity, buffer.getParticles().capacity());
 
-		EXPECT_EQ(0,buffer.size());
+		buffer.clear();
 
+		EXPECT_TRUE(buffer.empty());
+		EXPECT_EQ(0, buffer.size(TransferDirection(1,0,1)));
 	}
 
 }
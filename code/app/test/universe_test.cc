@@ -113,8 +113,11 @@ namespace ipic3d {
 		// initialize initial properties
 		Universe universe = createUniverseFromParams(params, "test");
 
-		// verify the number of particles per cell
-		int particlesPerCell = params.npcelx[0] * params.npcely[0] * params.npcelz[0];
+		// verify the number of particles per cell, covering all species
+		int particlesPerCell = 0;
+		for(int s = 0; s < params.ns; s++) {
+			particlesPerCell += params.npcelx[s] * params.npcely[s] * params.npcelz[s];
+		}
 
 		utils::Coordinate<3> zero = 0;
 		allscale::api::user::algorithm::pfor(zero, universe.properties.size, [&](const utils::Coordinate<3>& pos) {
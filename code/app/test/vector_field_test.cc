@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+
+#include "ipic3d/app/universe.h"
+#include "ipic3d/app/vector_field.h"
+
+namespace ipic3d {
+
+	TEST(VectorField, Basic) {
+
+		VectorField field({ 2,3,5 });
+		EXPECT_EQ(utils::Size<3>({ 2,3,5 }), field.size());
+		EXPECT_EQ(std::int64_t(VectorField::alignment), field.getStride());
+
+		// fields are initialized with zeros
+		EXPECT_EQ(Vector3<double>(0.0), (field[{ 1,2,4 }]));
+
+		// components are stored in planes of their own
+		field[{ 1,2,3 }] = { 1.0, 2.0, 3.0 };
+		EXPECT_EQ((Vector3<double>{ 1.0, 2.0, 3.0 }), (field[{ 1,2,3 }]));
+		EXPECT_EQ(1.0, field.pencil(0, 1, 2)[3]);
+		EXPECT_EQ(2.0, field.pencil(1, 1, 2)[3]);
+		EXPECT_EQ(3.0, field.pencil(2, 1, 2)[3]);
+
+		field[{ 1,2,3 }].y = 5.0;
+		EXPECT_EQ(5.0, field.pencil(1, 1, 2)[3]);
+	}
+
+	TEST(VectorField, Alignment) {
+
+		for(std::int64_t n : { 1, 7, 8, 9, 17 }) {
+			VectorField field({ 3,2,n });
+			EXPECT_LE(n, field.getStride());
+			EXPECT_EQ(0, field.getStride() % VectorField::alignment);
+			for(int d = 0; d < 3; ++d) {
+				for(std::int64_t x = 0; x < 3; ++x) {
+					for(std::int64_t y = 0; y < 2; ++y) {
+						EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(field.pencil(d, x, y)) % utils::MemoryPool::alignment) << d << "," << x << "," << y;
+					}
+				}
+			}
+		}
+	}
+
+	TEST(VectorField, LoadStore) {
+
+		Field grid({ 4,3,6 });
+		allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), grid.size(), [&](const auto& pos) {
+			grid[pos].E = { double(pos.x), double(pos.y), double(pos.z) };
+			grid[pos].B = Vector3<double>(0.0);
+		});
+
+		VectorField field(grid.size());
+		loadVectorField(grid, &FieldNode::E, field);
+		allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), grid.size(), [&](const auto& pos) {
+			EXPECT_EQ(grid[pos].E, field[pos]) << pos;
+		});
+
+		storeVectorField(field, grid, &FieldNode::B);
+		allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), grid.size(), [&](const auto& pos) {
+			EXPECT_EQ(grid[pos].E, grid[pos].B) << pos;
+		});
+	}
+
+	TEST(VectorField, Arithmetic) {
+
+		VectorField a({ 3,4,5 });
+		VectorField b({ 3,4,5 });
+		allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), a.size(), [&](const auto& pos) {
+			a[pos] = { 1.0, 2.0, double(pos.z) };
+			b[pos] = { double(pos.x), 1.0, 0.5 };
+		});
+
+		// 60 elements, the sums of x over all elements being 60, of z being 120
+		EXPECT_EQ(60.0 + 120.0 + 60.0, dotProduct(a, b));
+		EXPECT_EQ(std::sqrt(dotProduct(a, a)), norm(a));
+
+		addScaled(a, 2.0, b);
+		scale(a, Vector3<double>{ 1.0, 0.5, 2.0 });
+		allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), a.size(), [&](const auto& pos) {
+			EXPECT_EQ((Vector3<double>{ 1.0 + 2.0 * pos.x, 2.0, 2.0 * (pos.z + 1.0) }), a[pos]) << pos;
+		});
+
+		scale(a, 0.0);
+		EXPECT_EQ(0.0, norm(a));
+	}
+
+	TEST(VectorField, PeriodicHalo) {
+
+		// an interior of 3 elements along each dimension, with a two element wide upper ghost layer
+		utils::Size<3> period = { 3,3,3 };
+		VectorField field({ 6,5,6 });
+		allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), field.size(), [&](const auto& pos) {
+			field[pos] = { double(pos.x), double(pos.y), double(pos.z) };
+		});
+
+		updatePeriodicHalo(field, period);
+		allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), field.size(), [&](const auto& pos) {
+			utils::Coordinate<3> image = pos;
+			for(int d = 0; d < 3; ++d) {
+				if (pos[d] == 0) image[d] += period[d];
+				if (pos[d] > period[d]) image[d] -= period[d];
+			}
+			EXPECT_EQ((Vector3<double>{ double(image.x), double(image.y), double(image.z) }), field[pos]) << pos;
+		});
+
+		clearHalo(field, period);
+		allscale::api::user::algorithm::detail::forEach(utils::Coordinate<3>(0), field.size(), [&](const auto& pos) {
+			bool interior = utils::Coordinate<3>(0).strictlyDominatedBy(pos) && pos.strictlyDominatedBy(period + utils::Coordinate<3>(1));
+			Vector3<double> expected = { double(pos.x), double(pos.y), double(pos.z) };
+			EXPECT_EQ(interior ? expected : Vector3<double>(0.0), field[pos]) << pos;
+		});
+	}
+
+} // end namespace ipic3d